@@ -2,6 +2,8 @@
 #define BMP_H
 
 #pragma pack(1)
+// 结构体不使用 BITMAPFILEHEADER 等名字：Windows 的 <windows.h> 经 wingdi.h 定义了同名的类型，
+// 与 <windows.h> 一起引入时会重复定义
 // 文件头
 typedef struct {
     unsigned short bfType;
@@ -9,7 +11,7 @@ typedef struct {
     unsigned short bfReserved1;
     unsigned short bfReserved2;
     unsigned int bfOffBits;
-} BITMAPFILEHEADER;
+} BmpFileHeader;
 
 //信息头
 typedef struct {
@@ -24,7 +26,7 @@ typedef struct {
     int biYPelsPerMeter;
     unsigned int biClrUsed;
     unsigned int biClrImportant;
-} BITMAPINFOHEADER;
+} BmpInfoHeader;
 
 // 调色板
 typedef struct {
@@ -32,7 +34,7 @@ typedef struct {
     unsigned char rgbGreen;
     unsigned char rgbRed;
     unsigned char rgbReserved;
-} RGBQUAD;
+} BmpRgbQuad;
 
 #pragma pack()
 
@@ -1,210 +1,1435 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "bmp.h"
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "libgray2mono.h"
 
-// 二值化函数
-void binarize(unsigned char *data, int width, int height, int threshold, int windowSize)
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#define MKDIR(path) _mkdir(path)
+#else
+#define MKDIR(path) mkdir(path, 0755)
+#endif
+
+// 文件读写方式
+enum
+{
+    IO_STDIO,
+    IO_MMAP,
+    IO_STREAM
+};
+
+// 参数扫描中每个列表的最大长度
+#define MAX_SWEEP 64
+
+// 分块算法块大小的缓存文件，位于用户主目录，内容为 "宽 高"
+#define TILE_CACHE ".gray2mono_tiles"
+
+// 命令行参数
+typedef struct
 {
-    int padding = (4 - (width % 4)) % 4;
-    int rowSize = width + padding;
+    Gray2MonoSettings settings;
+    int io;
+    int batch;
+    int thresholds[MAX_SWEEP]; // -t 与 -r 给出多个值时进行参数扫描
+    int thresholdCount;
+    int windowSizes[MAX_SWEEP];
+    int windowCount;
+    int stats; // 输出各结果的前景像素统计
+} Options;
 
-    // 创建临时缓冲区 (考虑补位)
-    unsigned char *tempData = (unsigned char *)malloc(rowSize * height);
-    if (!tempData)
+// 检查失败时打印错误说明
+static int report(int error)
+{
+    if (error != GRAY2MONO_OK)
     {
-        printf("Memory allocation failed for tempData.\n");
-        return;
+        printf("%s\n", gray2monoErrorString(error));
     }
-    memcpy(tempData, data, rowSize * height);
+    return error;
+}
 
-    int halfWindow = windowSize / 2;
+// 顺序读取文件头、信息头与调色板并检查参数，读取后文件位于像素数据的开头
+static int readImageHeader(FILE *fp, Gray2MonoBmp *bmp, const Options *options)
+{
+    unsigned char header[sizeof(BmpFileHeader) + sizeof(BmpInfoHeader)];
 
-    // 对每个像素进行窗口均值计算
-    for (int y = 0; y < height; y++)
+    // 信息头文件头获取
+    if (fread(header, sizeof(header), 1, fp) != 1)
     {
-        for (int x = 0; x < width; x++)
-        {
-            int sum = 0;
-            int count = 0;
+        return report(GRAY2MONO_ERROR_HEADER);
+    }
+    if (report(gray2monoParseBmpHeader(header, bmp)) != 0 ||
+        report(gray2monoCheckSettings(&options->settings, bmp->width, bmp->height)) != 0)
+    {
+        return 1;
+    }
 
-            // 计算窗口内像素平均值
-            for (int wy = -halfWindow; wy <= halfWindow; wy++)
-            {
-                for (int wx = -halfWindow; wx <= halfWindow; wx++)
-                {
-                    int ny = y + wy;
-                    int nx = x + wx;
-
-                    if (ny >= 0 && ny < height && nx >= 0 && nx < width)
-                    {
-                        sum += tempData[ny * rowSize + nx];
-                        count++;
-                    }
-                }
-            }
+    // 读取到像素数据之前的全部内容，其中包含调色板
+    size_t skipped = bmp->pixelOffset - sizeof(header);
+    unsigned char *prefix = (unsigned char *)malloc(skipped + 1);
+    if (!prefix || fread(prefix, 1, skipped, fp) != skipped)
+    {
+        printf("Failed to read palette.\n");
+        free(prefix);
+        return 1;
+    }
+    if (bmp->bitCount == 8)
+    {
+        gray2monoParseBmpPalette(prefix + (bmp->paletteOffset - sizeof(header)), bmp);
+    }
+    free(prefix);
+    return 0;
+}
 
-            // 计算平均值并二值化
-            int average = sum / count;
-            data[y * rowSize + x] = (average > threshold) ? 255 : 0;
-        }
-        // 补位部分填充0
-        for (int p = 0; p < padding; p++)
+// 向文件写入文件头、信息头与调色板
+static void writeHeader(FILE *fp, const Gray2MonoLayout *layout)
+{
+    fwrite(&layout->fHeader, sizeof(BmpFileHeader), 1, fp);
+    fwrite(&layout->iHeader, sizeof(BmpInfoHeader), 1, fp);
+    fwrite(layout->palette, sizeof(BmpRgbQuad), layout->paletteCount, fp);
+}
+
+// 读取缓存的分块大小；没有缓存或内容无效时试运行一次并写入缓存，之后的运行跳过试运行
+static void loadTileSize(void)
+{
+#ifdef _WIN32
+    const char *home = getenv("USERPROFILE");
+#else
+    const char *home = getenv("HOME");
+#endif
+    if (!home)
+    {
+        // 没有主目录时由库在首次二值化时试运行
+        return;
+    }
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", home, TILE_CACHE);
+
+    int width, height;
+    FILE *fp = fopen(path, "r");
+    if (fp)
+    {
+        int loaded = fscanf(fp, "%d %d", &width, &height) == 2 && gray2monoSetTileSize(width, height) == GRAY2MONO_OK;
+        fclose(fp);
+        if (loaded)
         {
-            data[y * rowSize + width + p] = 0;
+            return;
         }
     }
 
-    free(tempData);
+    Gray2MonoContext *context = gray2monoCreate();
+    if (!context)
+    {
+        return;
+    }
+    gray2monoTileSize(context, &width, &height);
+    gray2monoDestroy(context);
+    printf("Tile size: %dx%d\n", width, height);
+
+    fp = fopen(path, "w");
+    if (fp)
+    {
+        fprintf(fp, "%d %d\n", width, height);
+        fclose(fp);
+    }
 }
 
-int main(int argc, char *argv[])
+// 自动阈值时每次累加直方图的行数
+#define HISTOGRAM_ROWS 64
+
+// 均值方法下是否需要自动阈值
+static int isAutoThreshold(const Gray2MonoSettings *settings)
 {
-    // 参数检测
-    if (argc != 5)
+    return settings->method == GRAY2MONO_METHOD_MEAN && settings->threshold == GRAY2MONO_THRESHOLD_AUTO;
+}
+
+// 由直方图求出 Otsu 阈值并打印
+static void applyOtsu(Gray2MonoSettings *settings, const unsigned long long histogram[256])
+{
+    settings->threshold = gray2monoOtsu(histogram);
+    printf("Otsu threshold: %d\n", settings->threshold);
+}
+
+// 读取像素数据（包含补位），histogram 不为 NULL 时每读入 HISTOGRAM_ROWS 行就累加这些行的直方图，
+// 此时这些行仍在缓存中，求自动阈值不需要再遍历一次图像
+static int readPixels(Gray2MonoContext *context, FILE *fp, const Gray2MonoBmp *bmp, unsigned char *data, unsigned long long *histogram)
+{
+    if (!histogram)
     {
-        printf("Usage: %s <input image> <output image> <threshold> <window size>\n", argv[0]);
-        return 1;
+        size_t size = bmp->rowSize * bmp->height;
+        return fread(data, 1, size, fp) == size ? 0 : 1;
     }
 
+    Gray2MonoImage image;
+    gray2monoBmpImage(bmp, data, &image);
+    for (int y = 0; y < bmp->height; y += HISTOGRAM_ROWS)
+    {
+        int rows = bmp->height - y < HISTOGRAM_ROWS ? bmp->height - y : HISTOGRAM_ROWS;
+        size_t size = bmp->rowSize * rows;
+        if (fread(data + bmp->rowSize * y, 1, size, fp) != size ||
+            gray2monoHistogram(context, &image, y, y + rows, histogram) != GRAY2MONO_OK)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 标准文件读写：整图读入内存，原地二值化后写出
+static int processStdio(Gray2MonoContext *context, const char *input, const char *output, const Options *options)
+{
     // 文件打开
-    FILE *fp = fopen(argv[1], "rb");
+    FILE *fp = fopen(input, "rb");
     if (!fp)
     {
-        printf("Cannot open file: %s\n", argv[1]);
+        printf("Cannot open file: %s\n", input);
         return 1;
     }
 
-    int threshold, windowSize;
-
-    // 参数输入
-    if (strstr(argv[3], "-t") != NULL)
+    Gray2MonoBmp bmp;
+    if (readImageHeader(fp, &bmp, options) != 0)
     {
-        strtok(argv[3], "=");
-        threshold = atoi(strtok(NULL, "="));
-        strtok(argv[4], "=");
-        windowSize = atoi(strtok(NULL, "="));
+        fclose(fp);
+        return 1;
     }
-    else
+
+    // 高度为负表示自上而下存储，窗口上下对称，按文件中的行序处理即可
+    size_t imageSize = bmp.rowSize * bmp.height;
+    unsigned char *imageData = (unsigned char *)malloc(imageSize);
+    if (!imageData)
     {
-        strtok(argv[3], "=");
-        windowSize = atoi(strtok(NULL, "="));
-        strtok(argv[4], "=");
-        threshold = atoi(strtok(NULL, "="));
+        printf("Memory allocation failed for imageData.\n");
+        fclose(fp);
+        return 1;
     }
 
-    BITMAPFILEHEADER fHeader;
-    BITMAPINFOHEADER iHeader;
-
-    // 信息头文件头获取
-    if (fread(&fHeader, sizeof(BITMAPFILEHEADER), 1, fp) != 1 ||
-        fread(&iHeader, sizeof(BITMAPINFOHEADER), 1, fp) != 1)
+    // 读取图像数据（包含补位），自动阈值的直方图在读取的同时建立
+    Gray2MonoSettings settings = options->settings;
+    unsigned long long histogram[256] = {0};
+    int automatic = isAutoThreshold(&settings);
+    if (readPixels(context, fp, &bmp, imageData, automatic ? histogram : NULL) != 0)
     {
-        printf("Failed to read file or info header.\n");
+        printf("Failed to read image data.\n");
+        free(imageData);
         fclose(fp);
         return 1;
     }
+    fclose(fp);
+    if (automatic)
+    {
+        applyOtsu(&settings, histogram);
+    }
 
-    // 文件位深检测
-    if (iHeader.biBitCount != 8)
+    // 原地二值化，输出按输出行宽从 imageData 开头存放
+    Gray2MonoLayout layout;
+    Gray2MonoImage image;
+    gray2monoBmpLayout(&layout, &bmp, settings.bitCount);
+    gray2monoBmpImage(&bmp, imageData, &image);
+    if (report(gray2monoBinarize(context, &image, imageData, (int)layout.rowSize, &settings)) != 0)
     {
-        printf("Only 8-bit grayscale images are supported.\n");
-        fclose(fp);
+        free(imageData);
         return 1;
     }
 
-    // 阈值检测
-    if (threshold < 0 || threshold > 255)
+    // 文件创建
+    fp = fopen(output, "wb");
+    if (!fp)
     {
-        printf("Threshold must be between 0 and 255.\n");
+        printf("Cannot create output file\n");
+        free(imageData);
         return 1;
     }
 
-    // 窗口检测
-    if (windowSize <= 0 || windowSize > iHeader.biWidth || windowSize > iHeader.biHeight || windowSize % 2 == 0)
+    // 文件头部信息写入
+    writeHeader(fp, &layout);
+
+    // 写入图像数据（包含补位）
+    fwrite(imageData, 1, layout.rowSize * bmp.height, fp);
+
+    fclose(fp);
+    free(imageData);
+    return 0;
+}
+
+#ifndef _WIN32
+// 创建大小为 size 的输出文件并可写映射，失败返回 NULL
+static unsigned char *mapOutput(const char *path, size_t size)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    unsigned char *map = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0)
+    {
+        map = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        // 不留下创建后未能映射的空文件
+        unlink(path);
+        return NULL;
+    }
+    return map;
+}
+
+// 内存映射读写：输入只读映射，输出 ftruncate 后可写映射，
+// 二值化直接读取输入映射中的像素并写入输出映射，没有整图拷贝和逐行的读写调用
+// 返回 -1 表示无法映射（如输入不是普通文件），由调用者退回标准文件读写
+static int processMapped(Gray2MonoContext *context, const char *input, const char *output, const Options *options)
+{
+    int inFd = open(input, O_RDONLY);
+    if (inFd < 0)
+    {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(inFd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+        close(inFd);
+        return -1;
+    }
+
+    // 输出与输入为同一个文件时，创建输出会截断仍在映射中的输入，改用先整图读入的标准文件读写
+    struct stat outSt;
+    if (stat(output, &outSt) == 0 && outSt.st_dev == st.st_dev && outSt.st_ino == st.st_ino)
     {
-        printf("Invalid window size.\n");
+        close(inFd);
+        return -1;
+    }
+
+    size_t inSize = (size_t)st.st_size;
+    unsigned char *inMap = (unsigned char *)mmap(NULL, inSize, PROT_READ, MAP_SHARED, inFd, 0);
+    close(inFd);
+    if (inMap == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    Gray2MonoBmp bmp;
+    if (report(gray2monoDecodeBmp(inMap, inSize, &bmp)) != 0 ||
+        report(gray2monoCheckSettings(&options->settings, bmp.width, bmp.height)) != 0)
+    {
+        munmap(inMap, inSize);
         return 1;
     }
 
-    // 临时打印
-    printf("WindowSize: %d, Threshold: %d\n", windowSize, threshold);
+    Gray2MonoLayout layout;
+    gray2monoBmpLayout(&layout, &bmp, options->settings.bitCount);
 
-    // 调色板读取
-    int paletteCount = 1 << iHeader.biBitCount;
-    RGBQUAD palette[paletteCount];
-    if (fread(palette, sizeof(RGBQUAD), paletteCount, fp) != paletteCount)
+    // 文件创建
+    size_t outSize = layout.fileSize;
+    unsigned char *outMap = mapOutput(output, outSize);
+    if (!outMap)
     {
-        printf("Failed to read palette.\n");
-        fclose(fp);
+        printf("Cannot create output file\n");
+        munmap(inMap, inSize);
         return 1;
     }
 
-    // 计算相关的值
-    int padding = (4 - (iHeader.biWidth % 4)) % 4;
-    int rowSize = iHeader.biWidth + padding;
-    int imageSize = rowSize * iHeader.biHeight;
-    unsigned char *imageData = (unsigned char *)malloc(imageSize);
-    if (!imageData)
+    // 顺序访问提示，让内核提前预读
+    madvise(inMap, inSize, MADV_SEQUENTIAL);
+
+    // 文件头部信息写入
+    gray2monoEncodeBmpHeader(outMap, &layout);
+
+    Gray2MonoImage image;
+    gray2monoBmpImage(&bmp, inMap + bmp.pixelOffset, &image);
+
+    // 映射的输入没有单独的读取过程，自动阈值需要先遍历一次映射建立直方图
+    Gray2MonoSettings settings = options->settings;
+    int result = 0;
+    if (isAutoThreshold(&settings))
     {
-        printf("Memory allocation failed for imageData.\n");
+        unsigned long long histogram[256] = {0};
+        result = report(gray2monoHistogram(context, &image, 0, image.height, histogram)) != 0;
+        applyOtsu(&settings, histogram);
+    }
+
+    // 二值化，直接从输入映射写入输出映射
+    if (!result)
+    {
+        result = report(gray2monoBinarize(context, &image, outMap + layout.headerSize, (int)layout.rowSize, &settings)) != 0;
+    }
+
+    munmap(outMap, outSize);
+    munmap(inMap, inSize);
+    if (result != 0)
+    {
+        // 与参数扫描相同，失败时不留下只写了一部分的输出文件
+        unlink(output);
+    }
+    return result;
+}
+#endif
+
+// 流式处理：顺序读入每一行，窗口凑齐后立即写出对应的输出行，
+// 内存占用为 O(W*r)，适合超过内存大小的图像
+static int processStream(Gray2MonoContext *context, const char *input, const char *output, const Options *options)
+{
+    // 文件打开
+    FILE *fp = fopen(input, "rb");
+    if (!fp)
+    {
+        printf("Cannot open file: %s\n", input);
+        return 1;
+    }
+
+    Gray2MonoBmp bmp;
+    Gray2MonoImage format;
+    if (readImageHeader(fp, &bmp, options) != 0)
+    {
+        fclose(fp);
         return 1;
     }
+    gray2monoBmpImage(&bmp, NULL, &format);
 
-    // 逐行读取图像数据（包含补位）
-    for (int y = 0; y < iHeader.biHeight; y++)
+    // 流式处理在读完之前就要输出，自动阈值需要先把像素数据读一遍建立直方图，再回到像素数据的开头
+    Gray2MonoSettings settings = options->settings;
+    if (isAutoThreshold(&settings))
     {
-        if (fread(&imageData[y * rowSize], 1, iHeader.biWidth, fp) != iHeader.biWidth)
+        unsigned long long histogram[256] = {0};
+        unsigned char *rows = (unsigned char *)malloc(bmp.rowSize * HISTOGRAM_ROWS);
+        int error = !rows;
+        for (int y = 0; !error && y < bmp.height; y += HISTOGRAM_ROWS)
+        {
+            Gray2MonoImage chunk = format;
+            chunk.data = rows;
+            chunk.height = bmp.height - y < HISTOGRAM_ROWS ? bmp.height - y : HISTOGRAM_ROWS;
+            error = fread(rows, 1, bmp.rowSize * chunk.height, fp) != bmp.rowSize * chunk.height ||
+                    gray2monoHistogram(context, &chunk, 0, chunk.height, histogram) != GRAY2MONO_OK;
+        }
+        free(rows);
+        if (error || fseek(fp, (long)bmp.pixelOffset, SEEK_SET) != 0)
         {
             printf("Failed to read image data.\n");
             fclose(fp);
             return 1;
         }
-        if (padding > 0)
+        applyOtsu(&settings, histogram);
+    }
+
+    if (report(gray2monoStreamBegin(context, &format, &settings)) != 0)
+    {
+        fclose(fp);
+        return 1;
+    }
+
+    Gray2MonoLayout layout;
+    gray2monoBmpLayout(&layout, &bmp, settings.bitCount);
+
+    unsigned char *inRow = (unsigned char *)malloc(bmp.rowSize);
+    if (!inRow)
+    {
+        printf("Memory allocation failed for streaming buffers.\n");
+        fclose(fp);
+        return 1;
+    }
+
+    // 文件创建
+    FILE *out = fopen(output, "wb");
+    if (!out)
+    {
+        printf("Cannot create output file\n");
+        free(inRow);
+        fclose(fp);
+        return 1;
+    }
+
+    // 文件头部信息写入
+    writeHeader(out, &layout);
+
+    // 读完所有行后以 NULL 继续，直到写出最后一行
+    int result = 0;
+    for (int r = 0, written = 0; written < bmp.height; r++)
+    {
+        const unsigned char *row = NULL;
+
+        // 读入第 r 行（包含补位）
+        if (r < bmp.height)
         {
-            if (fread(&imageData[y * rowSize + iHeader.biWidth], 1, padding, fp) != padding)
+            if (fread(inRow, 1, bmp.rowSize, fp) != bmp.rowSize)
             {
                 printf("Failed to read image data.\n");
-                fclose(fp);
-                return 1;
+                result = 1;
+                break;
             }
+            row = inRow;
         }
+
+        const unsigned char *outRow = gray2monoStreamRow(context, row);
+        if (!outRow)
+        {
+            continue;
+        }
+        if (fwrite(outRow, 1, layout.rowSize, out) != layout.rowSize)
+        {
+            printf("Failed to write image data.\n");
+            result = 1;
+            break;
+        }
+        written++;
     }
+
+    fclose(out);
     fclose(fp);
+    free(inRow);
+    return result;
+}
 
-    // 二值化
-    binarize(imageData, iHeader.biWidth, iHeader.biHeight, threshold, windowSize);
+// 在输出路径的扩展名之前插入参数，如 out.bmp -> out_t128_r15.bmp
+static char *sweepPath(const char *output, int threshold, int windowSize)
+{
+    const char *dot = strrchr(output, '.');
+    const char *slash = strrchr(output, '/');
+    if (!dot || (slash && dot < slash))
+    {
+        dot = output + strlen(output);
+    }
 
-    // 文件创建
-    fp = fopen(argv[2], "wb");
-    if (!fp)
+    size_t length = strlen(output) + 32;
+    char *path = (char *)malloc(length);
+    if (path)
     {
-        printf("Cannot create output file\n");
-        free(imageData);
+        char name[16];
+        if (threshold == GRAY2MONO_THRESHOLD_AUTO)
+        {
+            snprintf(name, sizeof(name), "auto");
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%d", threshold);
+        }
+        snprintf(path, length, "%.*s_t%s_r%d%s", (int)(dot - output), output, name, windowSize, dot);
+    }
+    return path;
+}
+
+// 参数扫描：整图读入内存，所有窗口共用一张积分图，每种阈值与窗口的组合写出一个文件
+static int processSweep(Gray2MonoContext *context, const char *input, const char *output, const Options *options)
+{
+    // 文件读取
+    FILE *fp = fopen(input, "rb");
+    long size = -1;
+    if (fp && fseek(fp, 0, SEEK_END) == 0)
+    {
+        size = ftell(fp);
+        rewind(fp);
+    }
+    unsigned char *data = size > 0 ? (unsigned char *)malloc((size_t)size) : NULL;
+    if (!data || fread(data, 1, (size_t)size, fp) != (size_t)size)
+    {
+        printf("Cannot read file: %s\n", input);
+        free(data);
+        if (fp)
+        {
+            fclose(fp);
+        }
         return 1;
     }
+    fclose(fp);
 
-    // 设置二值化后的调色板
-    for (int i = 0; i < paletteCount; i++)
+    Gray2MonoBmp bmp;
+    if (report(gray2monoDecodeBmp(data, (size_t)size, &bmp)) != 0)
     {
-        palette[i].rgbBlue = palette[i].rgbGreen = palette[i].rgbRed = i;
-        palette[i].rgbReserved = 0;
+        free(data);
+        return 1;
     }
 
-    // 文件头部信息写入
-    fwrite(&fHeader, sizeof(BITMAPFILEHEADER), 1, fp);
-    fwrite(&iHeader, sizeof(BITMAPINFOHEADER), 1, fp);
-    fwrite(palette, sizeof(RGBQUAD), paletteCount, fp);
+    Gray2MonoLayout layout;
+    Gray2MonoImage image;
+    gray2monoBmpLayout(&layout, &bmp, options->settings.bitCount);
+    gray2monoBmpImage(&bmp, data + bmp.pixelOffset, &image);
 
-    // 逐行写入图像数据（包含补位）
-    for (int y = 0; y < iHeader.biHeight; y++)
+    // 列表中的 auto 替换为同一个 Otsu 阈值，输出文件名仍标记为 auto
+    int thresholds[MAX_SWEEP];
+    int otsu = -1;
+    for (int t = 0; t < options->thresholdCount; t++)
     {
-        fwrite(&imageData[y * rowSize], 1, rowSize, fp);
+        thresholds[t] = options->thresholds[t];
+        if (thresholds[t] == GRAY2MONO_THRESHOLD_AUTO)
+        {
+            if (otsu < 0)
+            {
+                Gray2MonoSettings settings = options->settings;
+                unsigned long long histogram[256] = {0};
+                if (report(gray2monoHistogram(context, &image, 0, image.height, histogram)) != 0)
+                {
+                    free(data);
+                    return 1;
+                }
+                applyOtsu(&settings, histogram);
+                otsu = settings.threshold;
+            }
+            thresholds[t] = otsu;
+        }
     }
 
-    fclose(fp);
-    free(imageData);
-    printf("Binarization completed, output file: %s\n", argv[2]);
+    // 每个输出是一个完整的文件：能映射时直接写入输出文件的映射，否则先放在内存中最后写出
+    int combinations = options->thresholdCount * options->windowCount;
+    char **paths = (char **)calloc(combinations, sizeof(char *));
+    unsigned char **files = (unsigned char **)calloc(combinations, sizeof(unsigned char *));
+    unsigned char **dsts = (unsigned char **)malloc(sizeof(unsigned char *) * combinations);
+    int *mapped = (int *)calloc(combinations, sizeof(int));
+    int *created = (int *)calloc(combinations, sizeof(int));
+    unsigned long long *foreground = (unsigned long long *)malloc(sizeof(unsigned long long) * combinations);
+    int result = !paths || !files || !dsts || !mapped || !created || !foreground;
 
-    return 0;
+    // 输出顺序与 dsts 一致：窗口在外层，阈值在内层
+    for (int i = 0; result == 0 && i < combinations; i++)
+    {
+        paths[i] = sweepPath(output, options->thresholds[i % options->thresholdCount],
+                             options->windowSizes[i / options->thresholdCount]);
+#ifndef _WIN32
+        files[i] = paths[i] ? mapOutput(paths[i], layout.fileSize) : NULL;
+        mapped[i] = files[i] != NULL;
+        created[i] = mapped[i];
+#endif
+        if (!files[i])
+        {
+            files[i] = (unsigned char *)malloc(layout.fileSize);
+        }
+        if (!paths[i] || !files[i])
+        {
+            result = 1;
+            break;
+        }
+        gray2monoEncodeBmpHeader(files[i], &layout);
+        dsts[i] = files[i] + layout.headerSize;
+    }
+    if (result != 0)
+    {
+        printf("Cannot create sweep outputs.\n");
+    }
+    else
+    {
+        result = report(gray2monoSweep(context, &image, thresholds, options->thresholdCount,
+                                       options->windowSizes, options->windowCount, dsts, (int)layout.rowSize,
+                                       options->stats ? foreground : NULL, &options->settings)) != 0;
+    }
+
+    for (int i = 0; files && i < combinations && files[i]; i++)
+    {
+        if (mapped[i])
+        {
+#ifndef _WIN32
+            munmap(files[i], layout.fileSize);
+#endif
+        }
+        else
+        {
+            FILE *out = result == 0 ? fopen(paths[i], "wb") : NULL;
+            if (out)
+            {
+                created[i] = 1;
+                if (fwrite(files[i], 1, layout.fileSize, out) != layout.fileSize)
+                {
+                    result = 1;
+                }
+                if (fclose(out) != 0 || result != 0)
+                {
+                    printf("Cannot write output file\n");
+                    result = 1;
+                }
+            }
+            else if (result == 0)
+            {
+                printf("Cannot create output file\n");
+                result = 1;
+            }
+            free(files[i]);
+        }
+    }
+
+    // 全部输出写完后才输出统计，任何一步失败时删除已经创建的输出，不留下只完成了一部分的参数组合
+    for (int i = 0; paths && i < combinations; i++)
+    {
+        if (result == 0 && options->stats)
+        {
+            double pixels = (double)bmp.width * bmp.height;
+            printf("%s: %llu foreground pixels (%.2f%%)\n", paths[i], foreground[i], foreground[i] * 100.0 / pixels);
+        }
+        if (result != 0 && created && created[i])
+        {
+            remove(paths[i]);
+        }
+        free(paths[i]);
+    }
+    free(data);
+    free(paths);
+    free(files);
+    free(dsts);
+    free(mapped);
+    free(created);
+    free(foreground);
+    return result;
 }
+
+// 批处理输入的形式
+enum
+{
+    BATCH_NONE,
+    BATCH_DIR,
+    BATCH_LIST
+};
+
+// 有界阻塞队列
+typedef struct
+{
+    void **items;
+    int capacity;
+    int head;
+    int count;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+} Queue;
+
+static int queueInit(Queue *queue, int capacity)
+{
+    queue->items = (void **)malloc(sizeof(void *) * capacity);
+    if (!queue->items)
+    {
+        return 1;
+    }
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+    return 0;
+}
+
+static void queueDestroy(Queue *queue)
+{
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_cond_destroy(&queue->notFull);
+    free(queue->items);
+}
+
+static void queuePush(Queue *queue, void *item)
+{
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->capacity)
+    {
+        pthread_cond_wait(&queue->notFull, &queue->mutex);
+    }
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static void *queuePop(Queue *queue)
+{
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0)
+    {
+        pthread_cond_wait(&queue->notEmpty, &queue->mutex);
+    }
+    void *item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    pthread_cond_signal(&queue->notFull);
+    pthread_mutex_unlock(&queue->mutex);
+    return item;
+}
+
+// 在流水线中流转的一张图像，输入输出缓冲区在图像之间复用
+typedef struct
+{
+    const char *path;
+    unsigned char *input;
+    size_t inputSize;
+    size_t inputCapacity;
+    unsigned char *output;
+    size_t outputSize;
+    size_t outputCapacity;
+    int failed;
+} BatchItem;
+
+// 批处理流水线：读取线程 -> 二值化线程 -> 写出线程
+typedef struct
+{
+    char **paths;
+    int pathCount;
+    const char *outputDir;
+    const Options *options;
+    int workers;
+    Queue freeItems;
+    Queue readItems;
+    Queue doneItems;
+    int failures;
+} Batch;
+
+// 按需扩大复用的缓冲区
+static int reserveBuffer(unsigned char **buffer, size_t *capacity, size_t size)
+{
+    if (size <= *capacity)
+    {
+        return 0;
+    }
+    unsigned char *grown = (unsigned char *)realloc(*buffer, size);
+    if (!grown)
+    {
+        return 1;
+    }
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+// 输出文件名与输入相同：取路径的最后一段
+static const char *outputName(const char *path)
+{
+    const char *name = path;
+    for (const char *c = path; *c; c++)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            name = c + 1;
+        }
+    }
+    return name;
+}
+
+static int compareOutputNames(const void *a, const void *b)
+{
+    return strcmp(outputName(*(char *const *)a), outputName(*(char *const *)b));
+}
+
+// 列表中不同目录下的同名文件会写到同一个输出，开始前按输出文件名排序检查
+static int checkOutputNames(char **paths, int count)
+{
+    char **sorted = (char **)malloc(sizeof(char *) * (count ? count : 1));
+    if (!sorted)
+    {
+        printf("Memory allocation failed for batch paths.\n");
+        return 1;
+    }
+    memcpy(sorted, paths, sizeof(char *) * count);
+    qsort(sorted, count, sizeof(char *), compareOutputNames);
+
+    int result = 0;
+    for (int i = 1; i < count; i++)
+    {
+        if (compareOutputNames(&sorted[i - 1], &sorted[i]) == 0)
+        {
+            printf("Duplicate output name %s: %s and %s\n", outputName(sorted[i]), sorted[i - 1], sorted[i]);
+            result = 1;
+            break;
+        }
+    }
+    free(sorted);
+    return result;
+}
+
+static void *batchReader(void *arg)
+{
+    Batch *batch = (Batch *)arg;
+
+    for (int i = 0; i < batch->pathCount; i++)
+    {
+        BatchItem *item = (BatchItem *)queuePop(&batch->freeItems);
+        item->path = batch->paths[i];
+        item->failed = 0;
+
+        FILE *fp = fopen(item->path, "rb");
+        long size = -1;
+        if (fp && fseek(fp, 0, SEEK_END) == 0)
+        {
+            size = ftell(fp);
+            rewind(fp);
+        }
+        if (size <= 0 || reserveBuffer(&item->input, &item->inputCapacity, (size_t)size) != 0 ||
+            fread(item->input, 1, (size_t)size, fp) != (size_t)size)
+        {
+            printf("Cannot read file: %s\n", item->path);
+            item->failed = 1;
+            size = 0;
+        }
+        if (fp)
+        {
+            fclose(fp);
+        }
+        item->inputSize = (size_t)size;
+        queuePush(&batch->readItems, item);
+    }
+
+    // 每个二值化线程一个结束标记
+    for (int i = 0; i < batch->workers; i++)
+    {
+        queuePush(&batch->readItems, NULL);
+    }
+    return NULL;
+}
+
+// 每个二值化线程使用自己的上下文，缓冲区在图像之间复用
+static void *batchWorker(void *arg)
+{
+    Batch *batch = (Batch *)arg;
+    BatchItem *item;
+    Gray2MonoContext *context = gray2monoCreate();
+
+    // 图像之间已经并行，每张图像单线程处理
+    Gray2MonoSettings settings = batch->options->settings;
+    settings.threads = 1;
+
+    while ((item = (BatchItem *)queuePop(&batch->readItems)) != NULL)
+    {
+        if (!item->failed)
+        {
+            int error = context ? gray2monoBinarizeBmp(context, item->input, item->inputSize, item->output, item->outputCapacity,
+                                                       &item->outputSize, &settings)
+                                : GRAY2MONO_ERROR_MEMORY;
+            // 输出缓冲区不足时扩大后重试
+            if (error == GRAY2MONO_ERROR_BUFFER)
+            {
+                error = reserveBuffer(&item->output, &item->outputCapacity, item->outputSize) != 0
+                            ? GRAY2MONO_ERROR_MEMORY
+                            : gray2monoBinarizeBmp(context, item->input, item->inputSize, item->output, item->outputCapacity,
+                                                   &item->outputSize, &settings);
+            }
+            if (error != GRAY2MONO_OK)
+            {
+                printf("Skipped: %s (%s)\n", item->path, gray2monoErrorString(error));
+                item->failed = 1;
+            }
+        }
+        queuePush(&batch->doneItems, item);
+    }
+
+    gray2monoDestroy(context);
+    queuePush(&batch->doneItems, NULL);
+    return NULL;
+}
+
+static void *batchWriter(void *arg)
+{
+    Batch *batch = (Batch *)arg;
+    int finished = 0;
+
+    while (finished < batch->workers)
+    {
+        BatchItem *item = (BatchItem *)queuePop(&batch->doneItems);
+        if (!item)
+        {
+            finished++;
+            continue;
+        }
+
+        if (!item->failed)
+        {
+            const char *name = outputName(item->path);
+            size_t length = strlen(batch->outputDir) + strlen(name) + 2;
+            char *output = (char *)malloc(length);
+            FILE *fp = NULL;
+            if (output)
+            {
+                snprintf(output, length, "%s/%s", batch->outputDir, name);
+                fp = fopen(output, "wb");
+            }
+            if (!fp || fwrite(item->output, 1, item->outputSize, fp) != item->outputSize)
+            {
+                printf("Cannot write output file for %s\n", item->path);
+                item->failed = 1;
+            }
+            if (fp)
+            {
+                fclose(fp);
+            }
+            free(output);
+        }
+
+        if (item->failed)
+        {
+            batch->failures++;
+        }
+        queuePush(&batch->freeItems, item);
+    }
+    return NULL;
+}
+
+// 判断文件名是否以 .bmp 结尾
+static int isBmpName(const char *name)
+{
+    size_t length = strlen(name);
+    if (length < 4)
+    {
+        return 0;
+    }
+    const char *ext = name + length - 4;
+    return ext[0] == '.' && (ext[1] | 0x20) == 'b' && (ext[2] | 0x20) == 'm' && (ext[3] | 0x20) == 'p';
+}
+
+// 向路径列表追加一项
+static int appendPath(char ***paths, int *count, int *capacity, const char *dir, const char *name)
+{
+    if (*count == *capacity)
+    {
+        int grown = *capacity ? *capacity * 2 : 64;
+        char **list = (char **)realloc(*paths, sizeof(char *) * grown);
+        if (!list)
+        {
+            return 1;
+        }
+        *paths = list;
+        *capacity = grown;
+    }
+
+    size_t length = (dir ? strlen(dir) + 1 : 0) + strlen(name) + 1;
+    char *path = (char *)malloc(length);
+    if (!path)
+    {
+        return 1;
+    }
+    if (dir)
+    {
+        snprintf(path, length, "%s/%s", dir, name);
+    }
+    else
+    {
+        snprintf(path, length, "%s", name);
+    }
+    (*paths)[(*count)++] = path;
+    return 0;
+}
+
+// 收集输入目录中的 BMP 文件，或输入列表文件中的每一行
+static int collectPaths(const char *input, int mode, char ***paths, int *count)
+{
+    int capacity = 0;
+    *paths = NULL;
+    *count = 0;
+
+    if (mode == BATCH_DIR)
+    {
+        DIR *dir = opendir(input);
+        if (!dir)
+        {
+            printf("Cannot open directory: %s\n", input);
+            return 1;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            if (isBmpName(entry->d_name) && appendPath(paths, count, &capacity, input, entry->d_name) != 0)
+            {
+                closedir(dir);
+                return 1;
+            }
+        }
+        closedir(dir);
+        return 0;
+    }
+
+    FILE *fp = fopen(input, "r");
+    if (!fp)
+    {
+        printf("Cannot open file: %s\n", input);
+        return 1;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), fp))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] && appendPath(paths, count, &capacity, NULL, line) != 0)
+        {
+            fclose(fp);
+            return 1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+// 启动读取与二值化线程，当前线程负责写出，返回后所有线程都已结束
+static int runBatch(Batch *batch, BatchItem *items, int itemCount)
+{
+    for (int i = 0; i < itemCount; i++)
+    {
+        queuePush(&batch->freeItems, &items[i]);
+    }
+
+    // 二值化线程创建失败时以已创建的数量继续
+    pthread_t reader;
+    pthread_t *workers = (pthread_t *)malloc(sizeof(pthread_t) * batch->workers);
+    int started = 0;
+    for (int i = 0; workers && i < batch->workers; i++)
+    {
+        if (pthread_create(&workers[started], NULL, batchWorker, batch) != 0)
+        {
+            break;
+        }
+        started++;
+    }
+    batch->workers = started;
+
+    int result = 0;
+    if (started > 0 && pthread_create(&reader, NULL, batchReader, batch) == 0)
+    {
+        batchWriter(batch);
+        pthread_join(reader, NULL);
+        printf("Batch completed: %d images, %d failed.\n", batch->pathCount, batch->failures);
+        result = batch->failures != 0;
+    }
+    else
+    {
+        printf("Cannot start batch threads.\n");
+        for (int i = 0; i < started; i++)
+        {
+            queuePush(&batch->readItems, NULL);
+        }
+        result = 1;
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    return result;
+}
+
+// 批处理：读取、二值化、写出三个阶段通过有界队列组成流水线，
+// 磁盘读写与计算重叠，缓冲区在图像之间复用
+static int processBatch(const char *input, const char *outputDir, const Options *options)
+{
+    Batch batch;
+    batch.outputDir = outputDir;
+    batch.options = options;
+    batch.workers = options->settings.threads;
+    batch.failures = 0;
+
+    // 流水线中同时存在的图像数，决定了内存上限
+    int itemCount = batch.workers * 2 + 2;
+    BatchItem *items = NULL;
+    Queue *queues[] = {&batch.freeItems, &batch.readItems, &batch.doneItems};
+    int capacities[] = {itemCount, itemCount + batch.workers, itemCount + batch.workers};
+    int queueCount = 0;
+
+    // 任何一步失败都经过末尾的统一清理
+    int result = 1;
+    int ready = collectPaths(input, options->batch, &batch.paths, &batch.pathCount) == 0 &&
+                (options->batch != BATCH_LIST || checkOutputNames(batch.paths, batch.pathCount) == 0);
+
+    // 输出目录不存在时创建
+    struct stat st;
+    if (ready && stat(outputDir, &st) != 0 && MKDIR(outputDir) != 0)
+    {
+        printf("Cannot create output directory: %s\n", outputDir);
+        ready = 0;
+    }
+
+    if (ready)
+    {
+        items = (BatchItem *)calloc(itemCount, sizeof(BatchItem));
+        while (items && queueCount < 3 && queueInit(queues[queueCount], capacities[queueCount]) == 0)
+        {
+            queueCount++;
+        }
+        if (queueCount < 3)
+        {
+            printf("Memory allocation failed for batch pipeline.\n");
+        }
+        else
+        {
+            result = runBatch(&batch, items, itemCount);
+        }
+    }
+
+    for (int i = 0; items && i < itemCount; i++)
+    {
+        free(items[i].input);
+        free(items[i].output);
+    }
+    for (int i = 0; i < batch.pathCount; i++)
+    {
+        free(batch.paths[i]);
+    }
+    free(batch.paths);
+    free(items);
+    for (int i = 0; i < queueCount; i++)
+    {
+        queueDestroy(queues[i]);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    // 参数检测
+    if (argc < 3)
+    {
+        printf("Usage: %s <input image> <output image> [-t=128|auto] [-r=3] [-a=box|tiled|integral|naive] [-j=threads] [-io=mmap|stdio|stream] [-bpp=8|1]\n"
+               "       [-m=mean|niblack|sauvola] [-k=k] [-R=128] [-stats=1]\n", argv[0]);
+        printf("       %s <input image> <output image> -t=100,128,160 -r=3,15 [options]\n", argv[0]);
+        printf("       %s <input directory|list file> <output directory> -b=dir|list [options]\n", argv[0]);
+        return 1;
+    }
+
+    Options options;
+    gray2monoDefaultSettings(&options.settings);
+    options.settings.threads = gray2monoHardwareConcurrency();
+    options.batch = BATCH_NONE;
+    options.thresholds[0] = options.settings.threshold;
+    options.thresholdCount = 1;
+    options.windowSizes[0] = options.settings.windowSize;
+    options.windowCount = 1;
+    options.stats = 0;
+#ifdef _WIN32
+    options.io = IO_STDIO;
+#else
+    options.io = IO_MMAP;
+#endif
+
+    // Niblack 默认 k = -0.2，Sauvola 默认 k = 0.5
+    int kGiven = 0;
+
+    // 参数输入，形如 -t=128
+    for (int i = 3; i < argc; i++)
+    {
+        char *value = strchr(argv[i], '=');
+        if (!value)
+        {
+            printf("Invalid parameter: %s\n", argv[i]);
+            return 1;
+        }
+        *value++ = '\0';
+
+        if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "-r") == 0)
+        {
+            // 逗号分隔的列表，如 -t=100,128,160
+            int *list = argv[i][1] == 't' ? options.thresholds : options.windowSizes;
+            int *count = argv[i][1] == 't' ? &options.thresholdCount : &options.windowCount;
+            *count = 0;
+            for (char *item = strtok(value, ","); item; item = strtok(NULL, ","))
+            {
+                if (*count == MAX_SWEEP)
+                {
+                    printf("Too many values for %s, at most %d.\n", argv[i], MAX_SWEEP);
+                    return 1;
+                }
+                list[(*count)++] = argv[i][1] == 't' && strcmp(item, "auto") == 0 ? GRAY2MONO_THRESHOLD_AUTO : atoi(item);
+            }
+            if (*count == 0)
+            {
+                printf("Invalid parameter: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-stats") == 0)
+        {
+            options.stats = atoi(value) != 0;
+        }
+        else if (strcmp(argv[i], "-j") == 0)
+        {
+            options.settings.threads = atoi(value);
+            if (options.settings.threads <= 0)
+            {
+                printf("Thread count must be positive.\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-a") == 0)
+        {
+            if (strcmp(value, "box") == 0)
+            {
+                options.settings.algorithm = GRAY2MONO_ALGORITHM_BOX;
+            }
+            else if (strcmp(value, "integral") == 0)
+            {
+                options.settings.algorithm = GRAY2MONO_ALGORITHM_INTEGRAL;
+            }
+            else if (strcmp(value, "naive") == 0)
+            {
+                options.settings.algorithm = GRAY2MONO_ALGORITHM_NAIVE;
+            }
+            else if (strcmp(value, "tiled") == 0)
+            {
+                options.settings.algorithm = GRAY2MONO_ALGORITHM_TILED;
+            }
+            else
+            {
+                printf("Unknown algorithm: %s\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-m") == 0)
+        {
+            if (strcmp(value, "mean") == 0)
+            {
+                options.settings.method = GRAY2MONO_METHOD_MEAN;
+            }
+            else if (strcmp(value, "niblack") == 0)
+            {
+                options.settings.method = GRAY2MONO_METHOD_NIBLACK;
+            }
+            else if (strcmp(value, "sauvola") == 0)
+            {
+                options.settings.method = GRAY2MONO_METHOD_SAUVOLA;
+            }
+            else
+            {
+                printf("Unknown method: %s\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-k") == 0)
+        {
+            options.settings.k = atof(value);
+            kGiven = 1;
+        }
+        else if (strcmp(argv[i], "-R") == 0)
+        {
+            options.settings.r = atof(value);
+            if (options.settings.r <= 0)
+            {
+                printf("R must be positive.\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-bpp") == 0)
+        {
+            options.settings.bitCount = atoi(value);
+            if (options.settings.bitCount != 8 && options.settings.bitCount != 1)
+            {
+                printf("Output bit depth must be 8 or 1.\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-b") == 0)
+        {
+            if (strcmp(value, "dir") == 0)
+            {
+                options.batch = BATCH_DIR;
+            }
+            else if (strcmp(value, "list") == 0)
+            {
+                options.batch = BATCH_LIST;
+            }
+            else
+            {
+                printf("Unknown batch input: %s\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-io") == 0)
+        {
+            if (strcmp(value, "mmap") == 0)
+            {
+                options.io = IO_MMAP;
+            }
+            else if (strcmp(value, "stdio") == 0)
+            {
+                options.io = IO_STDIO;
+            }
+            else if (strcmp(value, "stream") == 0)
+            {
+                options.io = IO_STREAM;
+            }
+            else
+            {
+                printf("Unknown io mode: %s\n", value);
+                return 1;
+            }
+        }
+        else
+        {
+            printf("Unknown parameter: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!kGiven)
+    {
+        options.settings.k = options.settings.method == GRAY2MONO_METHOD_SAUVOLA ? 0.5 : -0.2;
+    }
+
+    // 列表中的第一个值作为单次处理的参数
+    options.settings.threshold = options.thresholds[0];
+    options.settings.windowSize = options.windowSizes[0];
+    int sweep = options.thresholdCount > 1 || options.windowCount > 1 || options.stats;
+
+    // 参数扫描与流式处理不使用分块算法
+    if (options.settings.algorithm == GRAY2MONO_ALGORITHM_TILED && !sweep && options.io != IO_STREAM)
+    {
+        loadTileSize();
+    }
+
+    if (options.batch != BATCH_NONE)
+    {
+        if (sweep)
+        {
+            printf("Sweep is not supported in batch mode.\n");
+            return 1;
+        }
+        return processBatch(argv[1], argv[2], &options);
+    }
+
+    // 临时打印
+    if (!sweep && options.settings.threshold == GRAY2MONO_THRESHOLD_AUTO)
+    {
+        printf("WindowSize: %d, Threshold: auto\n", options.settings.windowSize);
+    }
+    else if (!sweep)
+    {
+        printf("WindowSize: %d, Threshold: %d\n", options.settings.windowSize, options.settings.threshold);
+    }
+
+    Gray2MonoContext *context = gray2monoCreate();
+    if (!context)
+    {
+        printf("%s\n", gray2monoErrorString(GRAY2MONO_ERROR_MEMORY));
+        return 1;
+    }
+
+    int result = -1;
+    if (sweep)
+    {
+        result = processSweep(context, argv[1], argv[2], &options);
+    }
+    else if (options.io == IO_STREAM)
+    {
+        result = processStream(context, argv[1], argv[2], &options);
+    }
+#ifndef _WIN32
+    else if (options.io == IO_MMAP)
+    {
+        result = processMapped(context, argv[1], argv[2], &options);
+    }
+#endif
+    if (result == -1)
+    {
+        result = processStdio(context, argv[1], argv[2], &options);
+    }
+    gray2monoDestroy(context);
+    if (result != 0)
+    {
+        return 1;
+    }
+
+    if (sweep)
+    {
+        printf("Sweep completed: %d outputs.\n", options.thresholdCount * options.windowCount);
+    }
+    else
+    {
+        printf("Binarization completed, output file: %s\n", argv[2]);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,2192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "libgray2mono.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAY2MONO_X86 1
+#include <immintrin.h>
+#endif
+
+// 参数扫描时每个条带积分图的目标大小
+#define SWEEP_BAND_BYTES (4u << 20)
+
+// 分块算法试运行所用的图像与窗口大小
+#define TUNE_WIDTH 1024
+#define TUNE_HEIGHT 512
+#define TUNE_WINDOW 15
+
+// 一次二值化的输入输出与参数，各实现只处理 [y0, y1) 行
+// src 为 8 位索引或 24/32 位 BGR(A)，读取时逐行转换为灰度
+// dst 为 8 位时每像素一字节 0/255，为 1 位时每 8 个像素打包为一字节
+typedef struct
+{
+    const unsigned char *src;
+    const unsigned char *lut; // 8 位图像调色板索引对应的灰度，NULL 表示像素值即为灰度
+    unsigned char *dst;
+    int width;
+    int height;
+    int rowSize;
+    int dstRowSize;
+    int srcBitCount;
+    int bitCount;
+    int threshold;
+    int windowSize;
+    int algorithm;
+    int method;
+    double k;
+    double r;
+    int tileWidth; // 分块算法的块大小
+    int tileHeight;
+
+    // 参数扫描时不为 NULL：dsts[w * thresholdCount + t] 为 windowSizes[w] 与 thresholds[t] 组合的输出，
+    // counts 累加各输出中的前景像素数，windowSize 为最大的窗口
+    unsigned char *const *dsts;
+    const int *thresholds;
+    int thresholdCount;
+    const int *windowSizes;
+    int windowCount;
+    atomic_ullong *counts;
+} BinarizeParams;
+
+// 每个工作线程的复用缓冲区
+// rows 为 1 位输出的行缓冲与灰度行各一行，work 为积分图或环形缓冲
+typedef struct
+{
+    unsigned char *rows;
+    size_t rowsCapacity;
+    void *work;
+    size_t workCapacity;
+} Scratch;
+
+// 按需扩大复用的缓冲区，内容不保留
+static int reserveBuffer(void **buffer, size_t *capacity, size_t size)
+{
+    if (size <= *capacity)
+    {
+        return 0;
+    }
+    void *grown = malloc(size);
+    if (!grown)
+    {
+        return 1;
+    }
+    free(*buffer);
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+size_t gray2monoRowSize(int width, int bitCount)
+{
+    return (((size_t)width * bitCount + 31) / 32) * 4;
+}
+
+// 将一行 0/255 像素打包为 1 位，最左侧的像素在最高位
+typedef void (*PackRowFunc)(const unsigned char *pixels, unsigned char *out, int width);
+
+static void packRowScalar(const unsigned char *pixels, unsigned char *out, int width)
+{
+    for (int x = 0; x < width; x += 8)
+    {
+        unsigned char byte = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            byte <<= 1;
+            if (x + i < width && pixels[x + i])
+            {
+                byte |= 1;
+            }
+        }
+        out[x / 8] = byte;
+    }
+}
+
+#ifdef GRAY2MONO_X86
+// 字节内位序翻转表
+static unsigned char reverseBits[256];
+
+static void initReverseBits(void)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        int reversed = 0;
+        for (int b = 0; b < 8; b++)
+        {
+            reversed |= ((i >> b) & 1) << (7 - b);
+        }
+        reverseBits[i] = (unsigned char)reversed;
+    }
+}
+
+// movemask 一次取出 16 个像素的最高位，低位对应左侧像素，再查表翻转位序
+__attribute__((target("sse2"))) static void packRowSSE2(const unsigned char *pixels, unsigned char *out, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)&pixels[x]));
+        out[x / 8] = reverseBits[mask & 0xFF];
+        out[x / 8 + 1] = reverseBits[(mask >> 8) & 0xFF];
+    }
+    packRowScalar(&pixels[x], &out[x / 8], width - x);
+}
+
+// 先在每 8 字节内倒序，movemask 得到的位序即为 BMP 的位序
+__attribute__((target("avx2"))) static void packRowAVX2(const unsigned char *pixels, unsigned char *out, int width)
+{
+    __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                       7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i bytes = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)&pixels[x]), reverse);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(bytes);
+        memcpy(&out[x / 8], &mask, 4);
+    }
+    packRowSSE2(&pixels[x], &out[x / 8], width - x);
+}
+#endif
+
+static PackRowFunc packRow = NULL;
+
+static PackRowFunc selectPackRow(void)
+{
+#ifdef GRAY2MONO_X86
+    __builtin_cpu_init();
+    initReverseBits();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return packRowAVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return packRowSSE2;
+    }
+#endif
+    return packRowScalar;
+}
+
+// 彩色转灰度使用 BT.601 权重的 7 位定点近似：Y = (38R + 75G + 15B + 64) >> 7
+// 权重之和为 128，灰色像素转换后不变；各权重不超过 127，可直接作为 pmaddubsw 的有符号操作数
+static unsigned char luma(unsigned int red, unsigned int green, unsigned int blue)
+{
+    return (unsigned char)((red * 38 + green * 75 + blue * 15 + 64) >> 7);
+}
+
+// 将一行 BGR 或 BGRA 像素转换为灰度
+typedef void (*GrayRowFunc)(const unsigned char *pixels, unsigned char *gray, int width);
+
+static void grayRow24Scalar(const unsigned char *pixels, unsigned char *gray, int width)
+{
+    for (int x = 0; x < width; x++)
+    {
+        gray[x] = luma(pixels[x * 3 + 2], pixels[x * 3 + 1], pixels[x * 3]);
+    }
+}
+
+static void grayRow32Scalar(const unsigned char *pixels, unsigned char *gray, int width)
+{
+    for (int x = 0; x < width; x++)
+    {
+        gray[x] = luma(pixels[x * 4 + 2], pixels[x * 4 + 1], pixels[x * 4]);
+    }
+}
+
+#ifdef GRAY2MONO_X86
+// pmaddubsw 得到 15B + 75G 与 38R 两个 16 位部分和，phaddw 合并为每像素一个和，
+// 最大为 255 * 128 + 64，不会溢出有符号 16 位
+__attribute__((target("ssse3"))) static __m128i lumaSSSE3(__m128i first, __m128i second)
+{
+    __m128i weights = _mm_setr_epi8(15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0);
+    __m128i sums = _mm_hadd_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights));
+    return _mm_srli_epi16(_mm_add_epi16(sums, _mm_set1_epi16(64)), 7);
+}
+
+// 每次处理 16 个像素，BGRA 的 A 权重为 0
+__attribute__((target("ssse3"))) static void grayRow32SSSE3(const unsigned char *pixels, unsigned char *gray, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i *p = (const __m128i *)&pixels[(size_t)x * 4];
+        __m128i low = lumaSSSE3(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+        __m128i high = lumaSSSE3(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+        _mm_storeu_si128((__m128i *)&gray[x], _mm_packus_epi16(low, high));
+    }
+    grayRow32Scalar(&pixels[(size_t)x * 4], &gray[x], width - x);
+}
+
+// 每次读取 16 字节，用 pshufb 将其中 4 个 BGR 像素展开为 BGR0
+// 最后一次读取越过所需字节 4 字节，因此至少剩余 18 个像素时才走向量路径，不会读出行外
+__attribute__((target("ssse3"))) static void grayRow24SSSE3(const unsigned char *pixels, unsigned char *gray, int width)
+{
+    __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    int x = 0;
+    for (; x + 18 <= width; x += 16)
+    {
+        const unsigned char *p = &pixels[(size_t)x * 3];
+        __m128i bgr[4];
+        for (int i = 0; i < 4; i++)
+        {
+            bgr[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&p[i * 12]), expand);
+        }
+        __m128i low = lumaSSSE3(bgr[0], bgr[1]);
+        __m128i high = lumaSSSE3(bgr[2], bgr[3]);
+        _mm_storeu_si128((__m128i *)&gray[x], _mm_packus_epi16(low, high));
+    }
+    grayRow24Scalar(&pixels[(size_t)x * 3], &gray[x], width - x);
+}
+
+__attribute__((target("avx2"))) static __m256i lumaAVX2(__m256i first, __m256i second)
+{
+    __m256i weights = _mm256_setr_epi8(15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0,
+                                       15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0);
+    __m256i sums = _mm256_hadd_epi16(_mm256_maddubs_epi16(first, weights), _mm256_maddubs_epi16(second, weights));
+    return _mm256_srli_epi16(_mm256_add_epi16(sums, _mm256_set1_epi16(64)), 7);
+}
+
+// 每次处理 32 个像素，phaddw 与压缩都在 lane 内进行，最后按 4 像素一组跨 lane 重排
+__attribute__((target("avx2"))) static void grayRow32AVX2(const unsigned char *pixels, unsigned char *gray, int width)
+{
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        const __m256i *p = (const __m256i *)&pixels[(size_t)x * 4];
+        __m256i low = lumaAVX2(_mm256_loadu_si256(p), _mm256_loadu_si256(p + 1));
+        __m256i high = lumaAVX2(_mm256_loadu_si256(p + 2), _mm256_loadu_si256(p + 3));
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order);
+        _mm256_storeu_si256((__m256i *)&gray[x], bytes);
+    }
+    grayRow32SSSE3(&pixels[(size_t)x * 4], &gray[x], width - x);
+}
+
+// 两个 lane 分别读取 4 个像素，同样只在剩余字节足够时走向量路径
+__attribute__((target("avx2"))) static void grayRow24AVX2(const unsigned char *pixels, unsigned char *gray, int width)
+{
+    __m256i expand = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x + 34 <= width; x += 32)
+    {
+        const unsigned char *p = &pixels[(size_t)x * 3];
+        __m256i bgr[4];
+        for (int i = 0; i < 4; i++)
+        {
+            __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&p[i * 24])),
+                                                    _mm_loadu_si128((const __m128i *)&p[i * 24 + 12]), 1);
+            bgr[i] = _mm256_shuffle_epi8(bytes, expand);
+        }
+        __m256i low = lumaAVX2(bgr[0], bgr[1]);
+        __m256i high = lumaAVX2(bgr[2], bgr[3]);
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order);
+        _mm256_storeu_si256((__m256i *)&gray[x], bytes);
+    }
+    grayRow24SSSE3(&pixels[(size_t)x * 3], &gray[x], width - x);
+}
+#endif
+
+static GrayRowFunc grayRow24 = NULL;
+static GrayRowFunc grayRow32 = NULL;
+
+static GrayRowFunc selectGrayRow(int bitCount)
+{
+#ifdef GRAY2MONO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return bitCount == 24 ? grayRow24AVX2 : grayRow32AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return bitCount == 24 ? grayRow24SSSE3 : grayRow32SSSE3;
+    }
+#endif
+    return bitCount == 24 ? grayRow24Scalar : grayRow32Scalar;
+}
+
+// 将一行源像素转换为灰度，8 位灰度图不需要转换，直接返回源行
+static const unsigned char *convertRow(const unsigned char *row, unsigned char *gray, int width, int bitCount, const unsigned char *lut)
+{
+    if (bitCount == 24)
+    {
+        grayRow24(row, gray, width);
+    }
+    else if (bitCount == 32)
+    {
+        grayRow32(row, gray, width);
+    }
+    else if (lut)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            gray[x] = lut[row[x]];
+        }
+    }
+    else
+    {
+        return row;
+    }
+    return gray;
+}
+
+// 源图像第 y 行的灰度，需要转换时写入 gray（一行宽），不生成整张灰度图
+static const unsigned char *sourceRow(const BinarizeParams *params, int y, unsigned char *gray)
+{
+    return convertRow(&params->src[(size_t)y * params->rowSize], gray, params->width, params->srcBitCount, params->lut);
+}
+
+// 源图像 (x, y) 处的灰度，供朴素实现随机访问
+static unsigned char sourcePixel(const BinarizeParams *params, int x, int y)
+{
+    const unsigned char *row = &params->src[(size_t)y * params->rowSize];
+    switch (params->srcBitCount)
+    {
+    case 24:
+        return luma(row[x * 3 + 2], row[x * 3 + 1], row[x * 3]);
+    case 32:
+        return luma(row[x * 4 + 2], row[x * 4 + 1], row[x * 4]);
+    default:
+        return params->lut ? params->lut[row[x]] : row[x];
+    }
+}
+
+// 第 y 行的计算结果写到哪里：8 位直接写入 dst，1 位先写入行缓冲
+static unsigned char *rowTarget(const BinarizeParams *params, unsigned char *rowBuffer, int y)
+{
+    return params->bitCount == 1 ? rowBuffer : &params->dst[(size_t)y * params->dstRowSize];
+}
+
+// 完成第 y 行：1 位时趁行缓冲还在缓存中打包写入 dst，然后将补位部分填充0
+static void finishRow(const BinarizeParams *params, const unsigned char *pixels, int y)
+{
+    unsigned char *out = &params->dst[(size_t)y * params->dstRowSize];
+    int used = params->width;
+
+    if (params->bitCount == 1)
+    {
+        packRow(pixels, out, params->width);
+        used = (params->width + 7) / 8;
+    }
+    for (int p = used; p < params->dstRowSize; p++)
+    {
+        out[p] = 0;
+    }
+}
+
+// 朴素实现：逐像素累加整个窗口，复杂度 O(W*H*r^2)
+static void binarizeNaive(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    unsigned char *rowBuffer = scratch->rows;
+    int width = params->width, height = params->height;
+    int threshold = params->threshold, windowSize = params->windowSize;
+    int halfWindow = windowSize / 2;
+
+    // 对每个像素进行窗口均值计算
+    for (int y = y0; y < y1; y++)
+    {
+        unsigned char *out = rowTarget(params, rowBuffer, y);
+        for (int x = 0; x < width; x++)
+        {
+            int sum = 0;
+            int count = 0;
+
+            // 计算窗口内像素平均值
+            for (int wy = -halfWindow; wy <= halfWindow; wy++)
+            {
+                for (int wx = -halfWindow; wx <= halfWindow; wx++)
+                {
+                    int ny = y + wy;
+                    int nx = x + wx;
+
+                    if (ny >= 0 && ny < height && nx >= 0 && nx < width)
+                    {
+                        sum += sourcePixel(params, nx, ny);
+                        count++;
+                    }
+                }
+            }
+
+            // 计算平均值并二值化
+            int average = sum / count;
+            out[x] = (average > threshold) ? 255 : 0;
+        }
+        finishRow(params, out, y);
+    }
+}
+
+// 积分图实现：每个像素的窗口和只需四次查表，复杂度 O(W*H)，与窗口大小无关
+static int binarizeIntegral(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    unsigned char *rowBuffer = scratch->rows, *gray = &scratch->rows[params->width];
+    int width = params->width, height = params->height;
+    int threshold = params->threshold, windowSize = params->windowSize;
+    int halfWindow = windowSize / 2;
+    size_t satWidth = (size_t)width + 1;
+
+    // 只为 [y0, y1) 及其上下 halfWindow 行的光晕建立积分图
+    int top = y0 - halfWindow < 0 ? 0 : y0 - halfWindow;
+    int bottom = y1 + halfWindow > height ? height : y1 + halfWindow;
+
+    // 积分图多一行一列的 0，sat[y][x] 为 [top, top + y) x [0, x) 的像素和
+    // 大图的像素和会超过 32 位，使用 64 位累加
+    if (reserveBuffer(&scratch->work, &scratch->workCapacity, satWidth * (bottom - top + 1) * sizeof(unsigned long long)) != 0)
+    {
+        return 1;
+    }
+    unsigned long long *sat = (unsigned long long *)scratch->work;
+
+    memset(sat, 0, satWidth * sizeof(unsigned long long));
+    for (int y = 0; y < bottom - top; y++)
+    {
+        const unsigned char *row = sourceRow(params, top + y, gray);
+        unsigned long long *above = &sat[(size_t)y * satWidth];
+        unsigned long long *current = &sat[(size_t)(y + 1) * satWidth];
+        unsigned long long rowSum = 0;
+
+        current[0] = 0;
+        for (int x = 0; x < width; x++)
+        {
+            rowSum += row[x];
+            current[x + 1] = above[x + 1] + rowSum;
+        }
+    }
+
+    for (int y = y0; y < y1; y++)
+    {
+        // 窗口在图像边界处裁剪，与朴素实现的 count 计数一致
+        int wy1 = y - halfWindow < 0 ? 0 : y - halfWindow;
+        int wy2 = y + halfWindow + 1 > height ? height : y + halfWindow + 1;
+        const unsigned long long *above = &sat[(size_t)(wy1 - top) * satWidth];
+        const unsigned long long *below = &sat[(size_t)(wy2 - top) * satWidth];
+        unsigned char *out = rowTarget(params, rowBuffer, y);
+
+        for (int x = 0; x < width; x++)
+        {
+            int x1 = x - halfWindow < 0 ? 0 : x - halfWindow;
+            int x2 = x + halfWindow + 1 > width ? width : x + halfWindow + 1;
+
+            unsigned long long sum = below[x2] - below[x1] - above[x2] + above[x1];
+            unsigned long long count = (unsigned long long)(x2 - x1) * (wy2 - wy1);
+
+            // 计算平均值并二值化
+            unsigned long long average = sum / count;
+            out[x] = (average > (unsigned long long)threshold) ? 255 : 0;
+        }
+        finishRow(params, out, y);
+    }
+
+    return 0;
+}
+
+// 滑动窗口的竖直累加与阈值比较
+// colSums[x] += add[x] - sub[x]，窗口和不小于 limit 的像素输出 255
+typedef void (*BoxStepFunc)(unsigned int *colSums, const unsigned int *add, const unsigned int *sub,
+                            unsigned char *out, int begin, int end, unsigned int limit);
+
+static void boxStepScalar(unsigned int *colSums, const unsigned int *add, const unsigned int *sub,
+                          unsigned char *out, int begin, int end, unsigned int limit)
+{
+    for (int x = begin; x < end; x++)
+    {
+        unsigned int sum = colSums[x] + add[x] - sub[x];
+        colSums[x] = sum;
+        out[x] = (sum >= limit) ? 255 : 0;
+    }
+}
+
+#ifdef GRAY2MONO_X86
+// 每次处理 16 个像素，比较结果饱和压缩为 0/255 字节
+__attribute__((target("sse2"))) static void boxStepSSE2(unsigned int *colSums, const unsigned int *add, const unsigned int *sub,
+                                                        unsigned char *out, int begin, int end, unsigned int limit)
+{
+    // limit 小于 2^31，可以使用有符号比较
+    __m128i bound = _mm_set1_epi32((int)limit - 1);
+    int x = begin;
+    for (; x + 16 <= end; x += 16)
+    {
+        __m128i mask[4];
+        for (int i = 0; i < 4; i++)
+        {
+            __m128i sum = _mm_loadu_si128((const __m128i *)&colSums[x + i * 4]);
+            sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)&add[x + i * 4]));
+            sum = _mm_sub_epi32(sum, _mm_loadu_si128((const __m128i *)&sub[x + i * 4]));
+            _mm_storeu_si128((__m128i *)&colSums[x + i * 4], sum);
+            mask[i] = _mm_cmpgt_epi32(sum, bound);
+        }
+        __m128i low = _mm_packs_epi32(mask[0], mask[1]);
+        __m128i high = _mm_packs_epi32(mask[2], mask[3]);
+        _mm_storeu_si128((__m128i *)&out[x], _mm_packs_epi16(low, high));
+    }
+    boxStepScalar(colSums, add, sub, out, x, end, limit);
+}
+
+// 每次处理 32 个像素，压缩后需要跨 lane 重排
+__attribute__((target("avx2"))) static void boxStepAVX2(unsigned int *colSums, const unsigned int *add, const unsigned int *sub,
+                                                        unsigned char *out, int begin, int end, unsigned int limit)
+{
+    __m256i bound = _mm256_set1_epi32((int)limit - 1);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = begin;
+    for (; x + 32 <= end; x += 32)
+    {
+        __m256i mask[4];
+        for (int i = 0; i < 4; i++)
+        {
+            __m256i sum = _mm256_loadu_si256((const __m256i *)&colSums[x + i * 8]);
+            sum = _mm256_add_epi32(sum, _mm256_loadu_si256((const __m256i *)&add[x + i * 8]));
+            sum = _mm256_sub_epi32(sum, _mm256_loadu_si256((const __m256i *)&sub[x + i * 8]));
+            _mm256_storeu_si256((__m256i *)&colSums[x + i * 8], sum);
+            mask[i] = _mm256_cmpgt_epi32(sum, bound);
+        }
+        __m256i low = _mm256_packs_epi32(mask[0], mask[1]);
+        __m256i high = _mm256_packs_epi32(mask[2], mask[3]);
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(low, high), order);
+        _mm256_storeu_si256((__m256i *)&out[x], bytes);
+    }
+    boxStepSSE2(colSums, add, sub, out, x, end, limit);
+}
+#endif
+
+static BoxStepFunc boxStep = NULL;
+
+// 运行时选择当前 CPU 支持的最快实现
+static BoxStepFunc selectBoxStep(void)
+{
+#ifdef GRAY2MONO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return boxStepAVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return boxStepSSE2;
+    }
+#endif
+    return boxStepScalar;
+}
+
+// 分块实现中一行内部像素的窗口和与阈值比较
+// above、below 为积分图中窗口上下两行、从第一个像素的窗口左列开始的位置，窗口和不小于 limit 的像素输出 255
+// 积分图按 2^32 取模累加，窗口和小于 2^31 时四项的差仍然精确，且可以使用有符号比较
+typedef void (*TileStepFunc)(const unsigned int *above, const unsigned int *below, unsigned char *out,
+                             int count, int windowSize, unsigned int limit);
+
+static void tileStepScalar(const unsigned int *above, const unsigned int *below, unsigned char *out,
+                           int count, int windowSize, unsigned int limit)
+{
+    for (int x = 0; x < count; x++)
+    {
+        unsigned int sum = below[x + windowSize] - below[x] - above[x + windowSize] + above[x];
+        out[x] = (sum >= limit) ? 255 : 0;
+    }
+}
+
+#ifdef GRAY2MONO_X86
+__attribute__((target("sse2"))) static void tileStepSSE2(const unsigned int *above, const unsigned int *below, unsigned char *out,
+                                                         int count, int windowSize, unsigned int limit)
+{
+    __m128i bound = _mm_set1_epi32((int)limit - 1);
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i mask[4];
+        for (int i = 0; i < 4; i++)
+        {
+            int p = x + i * 4;
+            __m128i sum = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&below[p + windowSize]), _mm_loadu_si128((const __m128i *)&below[p]));
+            sum = _mm_sub_epi32(sum, _mm_loadu_si128((const __m128i *)&above[p + windowSize]));
+            sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)&above[p]));
+            mask[i] = _mm_cmpgt_epi32(sum, bound);
+        }
+        __m128i low = _mm_packs_epi32(mask[0], mask[1]);
+        __m128i high = _mm_packs_epi32(mask[2], mask[3]);
+        _mm_storeu_si128((__m128i *)&out[x], _mm_packs_epi16(low, high));
+    }
+    tileStepScalar(&above[x], &below[x], &out[x], count - x, windowSize, limit);
+}
+
+__attribute__((target("avx2"))) static void tileStepAVX2(const unsigned int *above, const unsigned int *below, unsigned char *out,
+                                                         int count, int windowSize, unsigned int limit)
+{
+    __m256i bound = _mm256_set1_epi32((int)limit - 1);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x + 32 <= count; x += 32)
+    {
+        __m256i mask[4];
+        for (int i = 0; i < 4; i++)
+        {
+            int p = x + i * 8;
+            __m256i sum = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)&below[p + windowSize]), _mm256_loadu_si256((const __m256i *)&below[p]));
+            sum = _mm256_sub_epi32(sum, _mm256_loadu_si256((const __m256i *)&above[p + windowSize]));
+            sum = _mm256_add_epi32(sum, _mm256_loadu_si256((const __m256i *)&above[p]));
+            mask[i] = _mm256_cmpgt_epi32(sum, bound);
+        }
+        __m256i low = _mm256_packs_epi32(mask[0], mask[1]);
+        __m256i high = _mm256_packs_epi32(mask[2], mask[3]);
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(low, high), order);
+        _mm256_storeu_si256((__m256i *)&out[x], bytes);
+    }
+    tileStepSSE2(&above[x], &below[x], &out[x], count - x, windowSize, limit);
+}
+#endif
+
+static TileStepFunc tileStep = NULL;
+
+static TileStepFunc selectTileStep(void)
+{
+#ifdef GRAY2MONO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return tileStepAVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return tileStepSSE2;
+    }
+#endif
+    return tileStepScalar;
+}
+
+// 参数扫描中一行窗口均值与一个阈值的比较
+// 均值大于 threshold 的像素输出 255，返回其余（前景）像素的数量
+typedef unsigned int (*SweepStepFunc)(const unsigned char *mean, unsigned char *out, int width, unsigned char threshold);
+
+static unsigned int sweepStepScalar(const unsigned char *mean, unsigned char *out, int width, unsigned char threshold)
+{
+    unsigned int foreground = 0;
+    for (int x = 0; x < width; x++)
+    {
+        out[x] = mean[x] > threshold ? 255 : 0;
+        foreground += mean[x] <= threshold;
+    }
+    return foreground;
+}
+
+#ifdef GRAY2MONO_X86
+// min(mean, t) == mean 即 mean <= t，取反得到输出，前景的掩码与 1 相与后由 psadbw 累加
+__attribute__((target("sse2"))) static unsigned int sweepStepSSE2(const unsigned char *mean, unsigned char *out, int width, unsigned char threshold)
+{
+    __m128i bound = _mm_set1_epi8((char)threshold);
+    __m128i one = _mm_set1_epi8(1);
+    __m128i counts = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i *)&mean[x]);
+        __m128i below = _mm_cmpeq_epi8(_mm_min_epu8(value, bound), value);
+        _mm_storeu_si128((__m128i *)&out[x], _mm_andnot_si128(below, _mm_set1_epi8(-1)));
+        counts = _mm_add_epi64(counts, _mm_sad_epu8(_mm_and_si128(below, one), _mm_setzero_si128()));
+    }
+    unsigned int foreground = (unsigned int)(_mm_cvtsi128_si32(counts) + _mm_cvtsi128_si32(_mm_srli_si128(counts, 8)));
+    return foreground + sweepStepScalar(&mean[x], &out[x], width - x, threshold);
+}
+
+__attribute__((target("avx2"))) static unsigned int sweepStepAVX2(const unsigned char *mean, unsigned char *out, int width, unsigned char threshold)
+{
+    __m256i bound = _mm256_set1_epi8((char)threshold);
+    __m256i one = _mm256_set1_epi8(1);
+    __m256i counts = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i value = _mm256_loadu_si256((const __m256i *)&mean[x]);
+        __m256i below = _mm256_cmpeq_epi8(_mm256_min_epu8(value, bound), value);
+        _mm256_storeu_si256((__m256i *)&out[x], _mm256_andnot_si256(below, _mm256_set1_epi8(-1)));
+        counts = _mm256_add_epi64(counts, _mm256_sad_epu8(_mm256_and_si256(below, one), _mm256_setzero_si256()));
+    }
+    __m128i sums = _mm_add_epi64(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+    unsigned int foreground = (unsigned int)(_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    return foreground + sweepStepSSE2(&mean[x], &out[x], width - x, threshold);
+}
+#endif
+
+static SweepStepFunc sweepStep = NULL;
+
+static SweepStepFunc selectSweepStep(void)
+{
+#ifdef GRAY2MONO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return sweepStepAVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return sweepStepSSE2;
+    }
+#endif
+    return sweepStepScalar;
+}
+
+// 计算一行的水平窗口和，窗口在左右边界处裁剪
+static void boxRowSums(const unsigned char *row, unsigned int *rowSums, int width, int halfWindow)
+{
+    unsigned int sum = 0;
+    int x = 0;
+
+    for (int i = 0; i < halfWindow && i < width; i++)
+    {
+        sum += row[i];
+    }
+    // 左边界：窗口只进不出
+    for (; x < width && x - halfWindow - 1 < 0; x++)
+    {
+        if (x + halfWindow < width)
+        {
+            sum += row[x + halfWindow];
+        }
+        rowSums[x] = sum;
+    }
+    // 中间：窗口一进一出
+    for (; x + halfWindow < width; x++)
+    {
+        sum += row[x + halfWindow];
+        sum -= row[x - halfWindow - 1];
+        rowSums[x] = sum;
+    }
+    // 右边界：窗口只出不进
+    for (; x < width; x++)
+    {
+        sum -= row[x - halfWindow - 1];
+        rowSums[x] = sum;
+    }
+}
+
+// 更新列和并输出第 y 行
+static void boxOutputRow(unsigned int *colSums, const unsigned int *add, const unsigned int *sub, unsigned char *out,
+                         int y, int width, int height, int threshold, int windowSize)
+{
+    int halfWindow = windowSize / 2;
+
+    // average = sum / count > threshold 等价于 sum >= (threshold + 1) * count
+    int y1 = y - halfWindow < 0 ? 0 : y - halfWindow;
+    int y2 = y + halfWindow + 1 > height ? height : y + halfWindow + 1;
+    unsigned int rowLimit = (unsigned int)(threshold + 1) * (y2 - y1);
+
+    // 左右边界列窗口宽度不同，逐列计算
+    int interiorBegin = halfWindow < width ? halfWindow : width;
+    int interiorEnd = width - halfWindow > interiorBegin ? width - halfWindow : interiorBegin;
+    for (int x = 0; x < interiorBegin; x++)
+    {
+        unsigned int columns = (x + halfWindow + 1 > width ? width : x + halfWindow + 1);
+        boxStepScalar(colSums, add, sub, out, x, x + 1, rowLimit * columns);
+    }
+    boxStep(colSums, add, sub, out, interiorBegin, interiorEnd, rowLimit * windowSize);
+    for (int x = interiorEnd; x < width; x++)
+    {
+        unsigned int columns = width - (x - halfWindow);
+        boxStepScalar(colSums, add, sub, out, x, x + 1, rowLimit * columns);
+    }
+}
+
+// 窗口面积乘以 256 不超过 2^31 时，32 位累加和有符号 SIMD 比较都不会溢出
+static int boxSupported(int windowSize)
+{
+    return windowSize < 2896;
+}
+
+// 可分离的滑动窗口实现：先对每行求水平窗口和，再沿竖直方向维护各列的滑动和，
+// 只保存 windowSize + 1 行水平窗口和，复杂度 O(W*H)，内存 O(W*r)
+// 每个源行在写出对应输出行之前已被读取，因此单线程处理整图时 src 与 dst 可以是同一块内存
+static int binarizeBox(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    unsigned char *rowBuffer = scratch->rows, *gray = &scratch->rows[params->width];
+    int width = params->width, height = params->height;
+    int threshold = params->threshold, windowSize = params->windowSize;
+    int halfWindow = windowSize / 2;
+    int ringSize = windowSize + 1;
+    int top = y0 - halfWindow < 0 ? 0 : y0 - halfWindow;
+
+    // 环形缓冲、列和与一行 0，环形缓冲中的行在读取前都已写入，只需清零后两部分
+    if (reserveBuffer(&scratch->work, &scratch->workCapacity, (size_t)width * (ringSize + 2) * sizeof(unsigned int)) != 0)
+    {
+        return 1;
+    }
+    unsigned int *ring = (unsigned int *)scratch->work;
+    unsigned int *colSums = &ring[(size_t)width * ringSize];
+    unsigned int *zeros = &ring[(size_t)width * (ringSize + 1)];
+    memset(colSums, 0, (size_t)width * 2 * sizeof(unsigned int));
+
+    // 预先累加第 y0 行窗口中除最下一行以外的行
+    for (int r = top; r < y0 + halfWindow && r < height; r++)
+    {
+        unsigned int *rowSums = &ring[(size_t)(r % ringSize) * width];
+        boxRowSums(sourceRow(params, r, gray), rowSums, width, halfWindow);
+        for (int x = 0; x < width; x++)
+        {
+            colSums[x] += rowSums[x];
+        }
+    }
+
+    for (int y = y0; y < y1; y++)
+    {
+        int enter = y + halfWindow;
+        int leave = y - halfWindow - 1;
+        const unsigned int *add = zeros;
+        const unsigned int *sub = zeros;
+        unsigned char *out = rowTarget(params, rowBuffer, y);
+
+        if (enter < height)
+        {
+            unsigned int *rowSums = &ring[(size_t)(enter % ringSize) * width];
+            boxRowSums(sourceRow(params, enter, gray), rowSums, width, halfWindow);
+            add = rowSums;
+        }
+        if (leave >= top)
+        {
+            sub = &ring[(size_t)(leave % ringSize) * width];
+        }
+
+        boxOutputRow(colSums, add, sub, out, y, width, height, threshold, windowSize);
+        finishRow(params, out, y);
+    }
+
+    return 0;
+}
+
+// 完成第 y 行中从 x0 开始的 count 个像素：1 位时打包写入 dst（x0 为 8 的倍数），行的最后一段再将补位部分填充0
+static void finishTileRow(const BinarizeParams *params, const unsigned char *pixels, int x0, int count, int y)
+{
+    unsigned char *out = &params->dst[(size_t)y * params->dstRowSize];
+    int used = x0 + count;
+
+    if (params->bitCount == 1)
+    {
+        packRow(pixels, &out[x0 / 8], count);
+        used = (used + 7) / 8;
+    }
+    if (x0 + count == params->width)
+    {
+        for (int p = used; p < params->dstRowSize; p++)
+        {
+            out[p] = 0;
+        }
+    }
+}
+
+// 分块实现中窗口被左右边界裁剪的像素 [begin, end)，逐个计算窗口面积，out 从 begin 开始
+// above、below 为积分图中窗口上下两行，下标为像素横坐标减去块光晕的左边界 left
+static void tileBorder(const unsigned int *above, const unsigned int *below, unsigned char *out,
+                       int begin, int end, int left, int width, int halfWindow, unsigned int rowLimit)
+{
+    for (int x = begin; x < end; x++)
+    {
+        int x1 = (x - halfWindow < 0 ? 0 : x - halfWindow) - left;
+        int x2 = (x + halfWindow + 1 > width ? width : x + halfWindow + 1) - left;
+        unsigned int sum = below[x2] - below[x1] - above[x2] + above[x1];
+        out[x - begin] = (sum >= rowLimit * (x2 - x1)) ? 255 : 0;
+    }
+}
+
+// 分块实现：按 tileWidth x tileHeight 的二维块输出，每块只为块及其光晕建立积分图，
+// 积分图约为 L2 缓存大小，建立后立即在缓存中读取，不会像整条带的积分图那样在大窗口下跨越很多缓存行
+// 积分图使用 32 位、按 2^32 取模累加，窗口面积与 boxSupported 相同的限制保证窗口和精确
+// 窗口在左右边界内的像素窗口面积相同，由无边界判断的 SIMD 内核处理，其余像素逐个裁剪窗口
+// average = floor(sum / count) > threshold 等价于 sum >= (threshold + 1) * count，不做除法
+static int binarizeTiled(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    unsigned char *rowBuffer = scratch->rows, *gray = &scratch->rows[params->width];
+    int width = params->width, height = params->height;
+    int threshold = params->threshold, windowSize = params->windowSize;
+    int halfWindow = windowSize / 2;
+    int pixelSize = params->srcBitCount / 8;
+
+    // 块的宽高不小于窗口，光晕的重复计算不超过块本身；块宽为 16 的倍数，1 位输出的每段从整字节开始
+    int tileWidth = params->tileWidth > windowSize ? params->tileWidth : (windowSize + 15) / 16 * 16;
+    int tileHeight = params->tileHeight > windowSize ? params->tileHeight : windowSize;
+    size_t satWidth = (size_t)(tileWidth + halfWindow * 2 < width ? tileWidth + halfWindow * 2 : width) + 1;
+    size_t satHeight = (size_t)(tileHeight + halfWindow * 2 < height ? tileHeight + halfWindow * 2 : height) + 1;
+    if (reserveBuffer(&scratch->work, &scratch->workCapacity, satWidth * satHeight * sizeof(unsigned int)) != 0)
+    {
+        return 1;
+    }
+    unsigned int *sat = (unsigned int *)scratch->work;
+
+    for (int ty0 = y0; ty0 < y1; ty0 += tileHeight)
+    {
+        int ty1 = ty0 + tileHeight < y1 ? ty0 + tileHeight : y1;
+        int top = ty0 - halfWindow < 0 ? 0 : ty0 - halfWindow;
+        int bottom = ty1 + halfWindow > height ? height : ty1 + halfWindow;
+
+        for (int tx0 = 0; tx0 < width; tx0 += tileWidth)
+        {
+            int tx1 = tx0 + tileWidth < width ? tx0 + tileWidth : width;
+            int left = tx0 - halfWindow < 0 ? 0 : tx0 - halfWindow;
+            int right = tx1 + halfWindow > width ? width : tx1 + halfWindow;
+            size_t stride = (size_t)(right - left) + 1;
+
+            // sat[y][x] 为块光晕内 [top, top + y) x [left, left + x) 的像素和，只转换光晕内的源像素
+            memset(sat, 0, stride * sizeof(unsigned int));
+            for (int y = 0; y < bottom - top; y++)
+            {
+                const unsigned char *row = convertRow(&params->src[(size_t)(top + y) * params->rowSize + (size_t)left * pixelSize],
+                                                      gray, right - left, params->srcBitCount, params->lut);
+                unsigned int *above = &sat[(size_t)y * stride];
+                unsigned int *current = &sat[(size_t)(y + 1) * stride];
+                unsigned int rowSum = 0;
+
+                current[0] = 0;
+                for (int x = 0; x < right - left; x++)
+                {
+                    rowSum += row[x];
+                    current[x + 1] = above[x + 1] + rowSum;
+                }
+            }
+
+            // 左右两侧窗口被图像边界裁剪的像素数
+            int interiorBegin = halfWindow > tx0 ? (halfWindow < tx1 ? halfWindow : tx1) : tx0;
+            int interiorEnd = width - halfWindow < tx1 ? width - halfWindow : tx1;
+            if (interiorEnd < interiorBegin)
+            {
+                interiorEnd = interiorBegin;
+            }
+
+            for (int y = ty0; y < ty1; y++)
+            {
+                int wy1 = y - halfWindow < 0 ? 0 : y - halfWindow;
+                int wy2 = y + halfWindow + 1 > height ? height : y + halfWindow + 1;
+                const unsigned int *above = &sat[(size_t)(wy1 - top) * stride];
+                const unsigned int *below = &sat[(size_t)(wy2 - top) * stride];
+                unsigned int rowLimit = (unsigned int)(threshold + 1) * (wy2 - wy1);
+                unsigned char *out = params->bitCount == 1 ? rowBuffer : &params->dst[(size_t)y * params->dstRowSize + tx0];
+
+                tileBorder(above, below, out, tx0, interiorBegin, left, width, halfWindow, rowLimit);
+                tileStep(&above[interiorBegin - halfWindow - left], &below[interiorBegin - halfWindow - left], &out[interiorBegin - tx0],
+                         interiorEnd - interiorBegin, windowSize, rowLimit * windowSize);
+                tileBorder(above, below, &out[interiorEnd - tx0], interiorEnd, tx1, left, width, halfWindow, rowLimit);
+                finishTileRow(params, out, tx0, tx1 - tx0, y);
+            }
+        }
+    }
+
+    return 0;
+}
+
+// 局部统计实现：由像素值与像素平方两张积分图，在 O(1) 内得到每个窗口的均值 m 与标准差 s，
+// 用于 Niblack 与 Sauvola 方法，像素值大于局部阈值时输出 255
+// 平方和使用 64 位累加，方差用 double 计算，并截断到非负
+static int binarizeLocalStats(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    unsigned char *rowBuffer = scratch->rows, *gray = &scratch->rows[params->width];
+    int width = params->width, height = params->height;
+    int halfWindow = params->windowSize / 2;
+    size_t satWidth = (size_t)width + 1;
+
+    // 只为 [y0, y1) 及其上下 halfWindow 行的光晕建立积分图
+    int top = y0 - halfWindow < 0 ? 0 : y0 - halfWindow;
+    int bottom = y1 + halfWindow > height ? height : y1 + halfWindow;
+    size_t satSize = satWidth * (bottom - top + 1);
+
+    if (reserveBuffer(&scratch->work, &scratch->workCapacity, satSize * 2 * sizeof(unsigned long long)) != 0)
+    {
+        return 1;
+    }
+    unsigned long long *sat = (unsigned long long *)scratch->work;
+    unsigned long long *sqSat = &sat[satSize];
+
+    memset(sat, 0, satWidth * sizeof(unsigned long long));
+    memset(sqSat, 0, satWidth * sizeof(unsigned long long));
+    for (int y = 0; y < bottom - top; y++)
+    {
+        const unsigned char *row = sourceRow(params, top + y, gray);
+        size_t above = (size_t)y * satWidth;
+        size_t current = (size_t)(y + 1) * satWidth;
+        unsigned long long rowSum = 0, rowSqSum = 0;
+
+        sat[current] = 0;
+        sqSat[current] = 0;
+        for (int x = 0; x < width; x++)
+        {
+            rowSum += row[x];
+            rowSqSum += (unsigned int)row[x] * row[x];
+            sat[current + x + 1] = sat[above + x + 1] + rowSum;
+            sqSat[current + x + 1] = sqSat[above + x + 1] + rowSqSum;
+        }
+    }
+
+    for (int y = y0; y < y1; y++)
+    {
+        int wy1 = y - halfWindow < 0 ? 0 : y - halfWindow;
+        int wy2 = y + halfWindow + 1 > height ? height : y + halfWindow + 1;
+        size_t above = (size_t)(wy1 - top) * satWidth;
+        size_t below = (size_t)(wy2 - top) * satWidth;
+        const unsigned char *row = sourceRow(params, y, gray);
+        unsigned char *out = rowTarget(params, rowBuffer, y);
+
+        for (int x = 0; x < width; x++)
+        {
+            int x1 = x - halfWindow < 0 ? 0 : x - halfWindow;
+            int x2 = x + halfWindow + 1 > width ? width : x + halfWindow + 1;
+
+            double count = (double)(x2 - x1) * (wy2 - wy1);
+            double sum = (double)(sat[below + x2] - sat[below + x1] - sat[above + x2] + sat[above + x1]);
+            double sqSum = (double)(sqSat[below + x2] - sqSat[below + x1] - sqSat[above + x2] + sqSat[above + x1]);
+            double mean = sum / count;
+            double variance = sqSum / count - mean * mean;
+            double deviation = variance > 0 ? sqrt(variance) : 0;
+
+            double threshold = params->method == GRAY2MONO_METHOD_NIBLACK
+                                   ? mean + params->k * deviation
+                                   : mean * (1 + params->k * (deviation / params->r - 1));
+            out[x] = (row[x] > threshold) ? 255 : 0;
+        }
+        finishRow(params, out, y);
+    }
+
+    return 0;
+}
+
+// 左右边界处窗口被裁剪，逐像素做双精度除法：sum 与 count 都是小于 2^53 的整数，
+// 舍入误差远小于商与相邻整数的距离 1 / count，截断结果与整数除法 floor(sum / count) 相同
+static void sweepBorderMeans(const unsigned long long *above, const unsigned long long *below, unsigned char *mean,
+                             int begin, int end, int width, int half, int rows)
+{
+    for (int x = begin; x < end; x++)
+    {
+        int x1 = x - half < 0 ? 0 : x - half;
+        int x2 = x + half + 1 > width ? width : x + half + 1;
+        long long sum = (long long)(below[x2] - below[x1] - above[x2] + above[x1]);
+        mean[x] = (unsigned char)((double)sum / ((double)(x2 - x1) * rows));
+    }
+}
+
+// 由积分图的上下两行求一行的窗口均值，rows 为窗口在竖直方向上裁剪后的行数
+// 中间部分 count 不变，乘以倒数后商只可能在恰好整除时小 1，再用整数比较修正
+static void sweepMeans(const unsigned long long *above, const unsigned long long *below, unsigned char *mean,
+                       int width, int half, int rows)
+{
+    int begin = half < width ? half : width;
+    int end = width - half > begin ? width - half : begin;
+    sweepBorderMeans(above, below, mean, 0, begin, width, half, rows);
+    sweepBorderMeans(above, below, mean, end, width, width, half, rows);
+
+    long long count = (long long)(half * 2 + 1) * rows;
+    double reciprocal = 1.0 / (double)count;
+    const unsigned long long *belowLeft = below - half, *belowRight = below + half + 1;
+    const unsigned long long *aboveLeft = above - half, *aboveRight = above + half + 1;
+    for (int x = begin; x < end; x++)
+    {
+        long long sum = (long long)(belowRight[x] - belowLeft[x] - aboveRight[x] + aboveLeft[x]);
+        long long quotient = (long long)((double)sum * reciprocal);
+        quotient += (quotient + 1) * count <= sum;
+        mean[x] = (unsigned char)quotient;
+    }
+}
+
+// 参数扫描：为 [y0, y1) 及最大窗口的光晕建立一张积分图，所有窗口共用
+// 每行对每个窗口只求一次窗口均值，再在同一行上与所有阈值比较，均值 floor(sum / count) > t 与均值方法一致
+static int binarizeSweep(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    int width = params->width, height = params->height;
+    int halfWindow = params->windowSize / 2;
+    size_t satWidth = (size_t)width + 1;
+    int top = y0 - halfWindow < 0 ? 0 : y0 - halfWindow;
+    int bottom = y1 + halfWindow > height ? height : y1 + halfWindow;
+
+    // 行缓冲、灰度行与均值行
+    if (reserveBuffer((void **)&scratch->rows, &scratch->rowsCapacity, (size_t)width * 3) != 0 ||
+        reserveBuffer(&scratch->work, &scratch->workCapacity, satWidth * (bottom - top + 1) * sizeof(unsigned long long)) != 0)
+    {
+        return 1;
+    }
+    unsigned char *rowBuffer = scratch->rows, *gray = &scratch->rows[width], *mean = &scratch->rows[(size_t)width * 2];
+    unsigned long long *sat = (unsigned long long *)scratch->work;
+
+    memset(sat, 0, satWidth * sizeof(unsigned long long));
+    for (int y = 0; y < bottom - top; y++)
+    {
+        const unsigned char *row = sourceRow(params, top + y, gray);
+        unsigned long long *above = &sat[(size_t)y * satWidth];
+        unsigned long long *current = &sat[(size_t)(y + 1) * satWidth];
+        unsigned long long rowSum = 0;
+
+        current[0] = 0;
+        for (int x = 0; x < width; x++)
+        {
+            rowSum += row[x];
+            current[x + 1] = above[x + 1] + rowSum;
+        }
+    }
+
+    BinarizeParams output = *params;
+    for (int y = y0; y < y1; y++)
+    {
+        for (int w = 0; w < params->windowCount; w++)
+        {
+            int half = params->windowSizes[w] / 2;
+            int wy1 = y - half < 0 ? 0 : y - half;
+            int wy2 = y + half + 1 > height ? height : y + half + 1;
+            const unsigned long long *above = &sat[(size_t)(wy1 - top) * satWidth];
+            const unsigned long long *below = &sat[(size_t)(wy2 - top) * satWidth];
+
+            sweepMeans(above, below, mean, width, half, wy2 - wy1);
+            for (int t = 0; t < params->thresholdCount; t++)
+            {
+                int index = w * params->thresholdCount + t;
+                output.dst = params->dsts[index];
+                unsigned char *out = rowTarget(&output, rowBuffer, y);
+                unsigned int foreground = sweepStep(mean, out, width, (unsigned char)params->thresholds[t]);
+                finishRow(&output, out, y);
+                if (params->counts)
+                {
+                    atomic_fetch_add(&params->counts[index], foreground);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+// 1 位输出时每行先写入行缓冲再打包，非灰度输入时每个源行先转换到灰度行
+static int reserveRows(const BinarizeParams *params, Scratch *scratch)
+{
+    return reserveBuffer((void **)&scratch->rows, &scratch->rowsCapacity, (size_t)params->width * 2);
+}
+
+// 按所选方法与算法处理 [y0, y1) 行
+// 均值方法的分块与滑动窗口实现在内存不足或窗口过大时依次退回积分图和朴素实现，Niblack 与 Sauvola 使用局部统计实现
+static int binarizeRows(const BinarizeParams *params, int y0, int y1, Scratch *scratch)
+{
+    if (params->dsts)
+    {
+        return binarizeSweep(params, y0, y1, scratch) == 0 ? GRAY2MONO_OK : GRAY2MONO_ERROR_MEMORY;
+    }
+
+    if (reserveRows(params, scratch) != 0)
+    {
+        return GRAY2MONO_ERROR_MEMORY;
+    }
+
+    if (params->method != GRAY2MONO_METHOD_MEAN)
+    {
+        return binarizeLocalStats(params, y0, y1, scratch) == 0 ? GRAY2MONO_OK : GRAY2MONO_ERROR_MEMORY;
+    }
+    if (!(params->algorithm == GRAY2MONO_ALGORITHM_TILED && boxSupported(params->windowSize) &&
+          binarizeTiled(params, y0, y1, scratch) == 0) &&
+        !(params->algorithm == GRAY2MONO_ALGORITHM_BOX && boxSupported(params->windowSize) &&
+          binarizeBox(params, y0, y1, scratch) == 0) &&
+        !(params->algorithm != GRAY2MONO_ALGORITHM_NAIVE && binarizeIntegral(params, y0, y1, scratch) == 0))
+    {
+        binarizeNaive(params, y0, y1, scratch);
+    }
+    return GRAY2MONO_OK;
+}
+
+// 水平条带任务队列，工作线程通过原子计数领取条带
+typedef struct
+{
+    const BinarizeParams *params;
+    int bandHeight;
+    int bandCount;
+    atomic_int nextBand;
+    atomic_int error;
+} BandQueue;
+
+static void runBands(BandQueue *queue, Scratch *scratch)
+{
+    int band;
+
+    // 各条带只写自己的输出行，读取共享的源图像（含上下光晕），不需要加锁
+    while ((band = atomic_fetch_add(&queue->nextBand, 1)) < queue->bandCount)
+    {
+        int y0 = band * queue->bandHeight;
+        int y1 = y0 + queue->bandHeight > queue->params->height ? queue->params->height : y0 + queue->bandHeight;
+        int error = binarizeRows(queue->params, y0, y1, scratch);
+        if (error != GRAY2MONO_OK)
+        {
+            atomic_store(&queue->error, error);
+        }
+    }
+}
+
+// 线程池中的一个工作线程，index 小于本次任务的参与数时参与处理
+typedef struct
+{
+    Gray2MonoContext *context;
+    int index;
+    pthread_t thread;
+    Scratch scratch;
+} Worker;
+
+struct Gray2MonoContext
+{
+    Scratch scratch;     // 调用线程使用
+    unsigned char *copy; // 源图像与输出重叠时的源图像拷贝
+    size_t copyCapacity;
+    atomic_ullong *counts; // 参数扫描的前景像素数
+    size_t countsCapacity;
+    int *thresholds; // 参数扫描中自动阈值替换为 Otsu 阈值后的阈值列表
+    size_t thresholdsCapacity;
+
+    // 线程池在首次多线程处理时启动，之后在图像之间复用，直到上下文销毁
+    Worker **workers;
+    int workerCount;
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation; // 每发布一次任务加一
+    int participants;
+    int running;
+    int stop;
+    BandQueue queue;
+
+    // 流式处理的状态
+    Scratch stream;
+    BinarizeParams streamParams;
+    int streamRow; // 已送入的源行数，包括末尾的空行
+    int streamOut; // 已返回的输出行数
+};
+
+static void *workerMain(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+    Gray2MonoContext *context = worker->context;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&context->mutex);
+    for (;;)
+    {
+        while (!context->stop && context->generation == seen)
+        {
+            pthread_cond_wait(&context->start, &context->mutex);
+        }
+        if (context->stop)
+        {
+            break;
+        }
+        seen = context->generation;
+        if (worker->index >= context->participants)
+        {
+            continue;
+        }
+
+        pthread_mutex_unlock(&context->mutex);
+        runBands(&context->queue, &worker->scratch);
+        pthread_mutex_lock(&context->mutex);
+        if (--context->running == 0)
+        {
+            pthread_cond_signal(&context->done);
+        }
+    }
+    pthread_mutex_unlock(&context->mutex);
+    return NULL;
+}
+
+// 线程池扩充到 count 个工作线程，失败时保留已启动的线程
+static void startWorkers(Gray2MonoContext *context, int count)
+{
+    if (count <= context->workerCount)
+    {
+        return;
+    }
+    Worker **workers = (Worker **)realloc(context->workers, sizeof(Worker *) * count);
+    if (!workers)
+    {
+        return;
+    }
+    context->workers = workers;
+
+    while (context->workerCount < count)
+    {
+        Worker *worker = (Worker *)calloc(1, sizeof(Worker));
+        if (!worker)
+        {
+            return;
+        }
+        worker->context = context;
+        worker->index = context->workerCount;
+        if (pthread_create(&worker->thread, NULL, workerMain, worker) != 0)
+        {
+            free(worker);
+            return;
+        }
+        context->workers[context->workerCount++] = worker;
+    }
+}
+
+// 将图像切分为水平条带并行处理，输出与单线程完全一致
+// 以 bandHeight 行为一个条带，由 threads 个线程处理
+static int binarizeBands(Gray2MonoContext *context, const BinarizeParams *params, int threads, int bandHeight)
+{
+    BandQueue *queue = &context->queue;
+    queue->params = params;
+    queue->bandHeight = bandHeight;
+    queue->bandCount = (params->height + queue->bandHeight - 1) / queue->bandHeight;
+    atomic_init(&queue->nextBand, 0);
+    atomic_init(&queue->error, GRAY2MONO_OK);
+
+    if (threads > queue->bandCount)
+    {
+        threads = queue->bandCount;
+    }
+
+    // 当前线程也参与处理，线程创建失败时剩余条带由已有线程完成
+    startWorkers(context, threads - 1);
+    int helpers = threads - 1 < context->workerCount ? threads - 1 : context->workerCount;
+
+    pthread_mutex_lock(&context->mutex);
+    context->participants = helpers;
+    context->running = helpers;
+    context->generation++;
+    pthread_cond_broadcast(&context->start);
+    pthread_mutex_unlock(&context->mutex);
+
+    runBands(queue, &context->scratch);
+
+    pthread_mutex_lock(&context->mutex);
+    while (context->running > 0)
+    {
+        pthread_cond_wait(&context->done, &context->mutex);
+    }
+    pthread_mutex_unlock(&context->mutex);
+
+    return atomic_load(&queue->error);
+}
+
+static int binarizeThreaded(Gray2MonoContext *context, const BinarizeParams *params, int threads)
+{
+    // 每个线程约分到 4 个条带以平衡负载，条带不低于窗口高度以控制光晕的重复计算
+    int minBandHeight = params->windowSize > 16 ? params->windowSize : 16;
+    int bandHeight = (params->height + threads * 4 - 1) / (threads * 4);
+    return binarizeBands(context, params, threads, bandHeight > minBandHeight ? bandHeight : minBandHeight);
+}
+
+// 选择 SIMD 实现，只执行一次
+static void selectKernels(void)
+{
+    boxStep = selectBoxStep();
+    packRow = selectPackRow();
+    sweepStep = selectSweepStep();
+    tileStep = selectTileStep();
+    grayRow24 = selectGrayRow(24);
+    grayRow32 = selectGrayRow(32);
+}
+
+static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+
+// 多个线程可以各自使用不同的上下文同时调用，由 pthread_once 保证函数指针与查找表在使用前写入且只写入一次
+static void initKernels(void)
+{
+    pthread_once(&kernelsOnce, selectKernels);
+}
+
+void gray2monoDefaultSettings(Gray2MonoSettings *settings)
+{
+    settings->threshold = 128;
+    settings->windowSize = 3;
+    settings->algorithm = GRAY2MONO_ALGORITHM_BOX;
+    settings->method = GRAY2MONO_METHOD_MEAN;
+    settings->k = -0.2;
+    settings->r = 128;
+    settings->bitCount = 8;
+    settings->threads = 1;
+}
+
+const char *gray2monoErrorString(int error)
+{
+    switch (error)
+    {
+    case GRAY2MONO_OK:
+        return "Success.";
+    case GRAY2MONO_ERROR_HEADER:
+        return "Failed to read file or info header.";
+    case GRAY2MONO_ERROR_INVALID_HEADER:
+        return "Invalid header.";
+    case GRAY2MONO_ERROR_FORMAT:
+        return "Only 8-bit indexed and 24/32-bit color images are supported.";
+    case GRAY2MONO_ERROR_COMPRESSED:
+        return "Compressed images are not supported.";
+    case GRAY2MONO_ERROR_DATA:
+        return "Failed to read image data.";
+    case GRAY2MONO_ERROR_THRESHOLD:
+        return "Threshold must be between 0 and 255 or auto.";
+    case GRAY2MONO_ERROR_WINDOW:
+        return "Invalid window size.";
+    case GRAY2MONO_ERROR_SETTINGS:
+        return "Invalid settings.";
+    case GRAY2MONO_ERROR_STREAM_METHOD:
+        return "Streaming only supports the mean method.";
+    case GRAY2MONO_ERROR_STREAM_WINDOW:
+        return "Window size is too large for streaming (at most 2895).";
+    case GRAY2MONO_ERROR_BUFFER:
+        return "Output buffer is too small.";
+    case GRAY2MONO_ERROR_MEMORY:
+        return "Memory allocation failed.";
+    case GRAY2MONO_ERROR_SWEEP_METHOD:
+        return "Sweep only supports the mean method.";
+    case GRAY2MONO_ERROR_STREAM_THRESHOLD:
+        return "Streaming needs a fixed threshold.";
+    default:
+        return "Unknown error.";
+    }
+}
+
+int gray2monoHardwareConcurrency(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+int gray2monoCheckSettings(const Gray2MonoSettings *settings, int width, int height)
+{
+    // 阈值检测
+    if ((settings->threshold < 0 && settings->threshold != GRAY2MONO_THRESHOLD_AUTO) || settings->threshold > 255)
+    {
+        return GRAY2MONO_ERROR_THRESHOLD;
+    }
+
+    // 窗口检测
+    if (settings->windowSize <= 0 || settings->windowSize > width || settings->windowSize > height || settings->windowSize % 2 == 0)
+    {
+        return GRAY2MONO_ERROR_WINDOW;
+    }
+
+    if ((settings->bitCount != 8 && settings->bitCount != 1) ||
+        settings->algorithm < GRAY2MONO_ALGORITHM_NAIVE || settings->algorithm > GRAY2MONO_ALGORITHM_TILED ||
+        settings->method < GRAY2MONO_METHOD_MEAN || settings->method > GRAY2MONO_METHOD_SAUVOLA ||
+        !(settings->r > 0) || settings->threads <= 0)
+    {
+        return GRAY2MONO_ERROR_SETTINGS;
+    }
+    return GRAY2MONO_OK;
+}
+
+Gray2MonoContext *gray2monoCreate(void)
+{
+    Gray2MonoContext *context = (Gray2MonoContext *)calloc(1, sizeof(Gray2MonoContext));
+    if (!context)
+    {
+        return NULL;
+    }
+    pthread_mutex_init(&context->mutex, NULL);
+    pthread_cond_init(&context->start, NULL);
+    pthread_cond_init(&context->done, NULL);
+    return context;
+}
+
+static void freeScratch(Scratch *scratch)
+{
+    free(scratch->rows);
+    free(scratch->work);
+}
+
+void gray2monoDestroy(Gray2MonoContext *context)
+{
+    if (!context)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&context->mutex);
+    context->stop = 1;
+    pthread_cond_broadcast(&context->start);
+    pthread_mutex_unlock(&context->mutex);
+    for (int i = 0; i < context->workerCount; i++)
+    {
+        pthread_join(context->workers[i]->thread, NULL);
+        freeScratch(&context->workers[i]->scratch);
+        free(context->workers[i]);
+    }
+
+    pthread_mutex_destroy(&context->mutex);
+    pthread_cond_destroy(&context->start);
+    pthread_cond_destroy(&context->done);
+    freeScratch(&context->scratch);
+    freeScratch(&context->stream);
+    free(context->workers);
+    free(context->copy);
+    free(context->counts);
+    free(context->thresholds);
+    free(context);
+}
+
+// 检查输入图像并设置二值化参数
+// 直方图的子直方图个数
+// 同一个计数器连续自增时，每次都要等上一次的写入经存储转发读回，大片相同灰度的背景会形成一条依赖链；
+// 相邻像素轮流计入不同的子直方图后，相同灰度的自增互不依赖
+#define HISTOGRAM_LANES 4
+
+// 每次读取 8 个像素，按字节移位取出后轮流计入各子直方图
+static void countRow(const unsigned char *row, int width, unsigned int counts[HISTOGRAM_LANES][256])
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        unsigned long long pixels;
+        memcpy(&pixels, &row[x], 8);
+        counts[0][pixels & 0xFF]++;
+        counts[1][(pixels >> 8) & 0xFF]++;
+        counts[2][(pixels >> 16) & 0xFF]++;
+        counts[3][(pixels >> 24) & 0xFF]++;
+        counts[0][(pixels >> 32) & 0xFF]++;
+        counts[1][(pixels >> 40) & 0xFF]++;
+        counts[2][(pixels >> 48) & 0xFF]++;
+        counts[3][pixels >> 56]++;
+    }
+    for (; x < width; x++)
+    {
+        counts[x % HISTOGRAM_LANES][row[x]]++;
+    }
+}
+
+// 合并子直方图并清零，8 位索引图像在这里才经调色板映射为灰度，逐像素计数时不必查表
+static void flushCounts(unsigned int counts[HISTOGRAM_LANES][256], const unsigned char *lut, unsigned long long histogram[256])
+{
+    for (int i = 0; i < 256; i++)
+    {
+        unsigned long long total = 0;
+        for (int lane = 0; lane < HISTOGRAM_LANES; lane++)
+        {
+            total += counts[lane][i];
+            counts[lane][i] = 0;
+        }
+        histogram[lut ? lut[i] : i] += total;
+    }
+}
+
+int gray2monoHistogram(Gray2MonoContext *context, const Gray2MonoImage *src, int y0, int y1, unsigned long long histogram[256])
+{
+    if (src->bitCount != 8 && src->bitCount != 24 && src->bitCount != 32)
+    {
+        return GRAY2MONO_ERROR_FORMAT;
+    }
+    if (y0 < 0 || y1 > src->height || y0 > y1 || src->width < 0 || src->stride <= 0 ||
+        (size_t)src->stride < (size_t)src->width * (src->bitCount / 8))
+    {
+        return GRAY2MONO_ERROR_SETTINGS;
+    }
+
+    // 彩色图像逐行转换为灰度后计数
+    initKernels();
+    if (src->bitCount != 8 && reserveBuffer((void **)&context->scratch.rows, &context->scratch.rowsCapacity, (size_t)src->width) != 0)
+    {
+        return GRAY2MONO_ERROR_MEMORY;
+    }
+    const unsigned char *lut = src->bitCount == 8 ? src->lut : NULL;
+
+    unsigned int counts[HISTOGRAM_LANES][256];
+    memset(counts, 0, sizeof(counts));
+    size_t pending = 0;
+    for (int y = y0; y < y1; y++)
+    {
+        const unsigned char *row = &src->data[(size_t)y * src->stride];
+        if (src->bitCount != 8)
+        {
+            row = convertRow(row, context->scratch.rows, src->width, src->bitCount, NULL);
+        }
+
+        // 子直方图为 32 位计数，计满之前合并
+        if (pending + src->width > UINT_MAX)
+        {
+            flushCounts(counts, lut, histogram);
+            pending = 0;
+        }
+        countRow(row, src->width, counts);
+        pending += src->width;
+    }
+    flushCounts(counts, lut, histogram);
+    return GRAY2MONO_OK;
+}
+
+int gray2monoOtsu(const unsigned long long histogram[256])
+{
+    double total = 0, sum = 0;
+    for (int i = 0; i < 256; i++)
+    {
+        total += (double)histogram[i];
+        sum += (double)i * histogram[i];
+    }
+
+    // 逐个阈值累加下方一类的像素数与灰度和，类间方差为 w0 * w1 * (m0 - m1)^2
+    double weight = 0, partial = 0, best = 0;
+    int threshold = 0;
+    for (int t = 0; t < 255; t++)
+    {
+        weight += (double)histogram[t];
+        partial += (double)t * histogram[t];
+        if (weight == 0 || weight == total)
+        {
+            continue;
+        }
+        double difference = partial / weight - (sum - partial) / (total - weight);
+        double variance = weight * (total - weight) * difference * difference;
+        if (variance > best)
+        {
+            best = variance;
+            threshold = t;
+        }
+    }
+    return threshold;
+}
+
+// 由整幅图像的直方图求自动阈值，需要额外遍历一次源图像
+static int autoThreshold(Gray2MonoContext *context, const Gray2MonoImage *src, int *threshold)
+{
+    unsigned long long histogram[256] = {0};
+    int error = gray2monoHistogram(context, src, 0, src->height, histogram);
+    *threshold = gray2monoOtsu(histogram);
+    return error;
+}
+
+static int imageParams(BinarizeParams *params, const Gray2MonoImage *src, unsigned char *dst, int dstStride, const Gray2MonoSettings *settings)
+{
+    int error = gray2monoCheckSettings(settings, src->width, src->height);
+    if (error != GRAY2MONO_OK)
+    {
+        return error;
+    }
+    if (src->bitCount != 8 && src->bitCount != 24 && src->bitCount != 32)
+    {
+        return GRAY2MONO_ERROR_FORMAT;
+    }
+    // 行距先检查为正，负数转为 size_t 后会通过宽度检查
+    if (src->stride <= 0 || dstStride <= 0 ||
+        (size_t)src->stride < (size_t)src->width * (src->bitCount / 8) ||
+        (size_t)dstStride < ((size_t)src->width * settings->bitCount + 7) / 8)
+    {
+        return GRAY2MONO_ERROR_SETTINGS;
+    }
+
+    params->src = src->data;
+    params->lut = src->bitCount == 8 ? src->lut : NULL;
+    params->dst = dst;
+    params->width = src->width;
+    params->height = src->height;
+    params->rowSize = src->stride;
+    params->dstRowSize = dstStride;
+    params->srcBitCount = src->bitCount;
+    params->bitCount = settings->bitCount;
+    params->threshold = settings->threshold;
+    params->windowSize = settings->windowSize;
+    params->algorithm = settings->algorithm;
+    params->method = settings->method;
+    params->k = settings->k;
+    params->r = settings->r;
+    params->tileWidth = 0;
+    params->tileHeight = 0;
+    params->dsts = NULL;
+    params->counts = NULL;
+    return GRAY2MONO_OK;
+}
+
+// 单调时钟的秒数，用于分块大小的试运行
+static double monotonicSeconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+// 选定的块大小，高 16 位为宽，低 16 位为高，0 表示尚未选择；进程内所有上下文共用
+static atomic_int tileSize;
+
+// 在 TUNE_WIDTH x TUNE_HEIGHT 的噪声图上以 TUNE_WINDOW 的窗口单线程试运行各候选块大小，返回最快的
+// 每个候选运行两次取较快的一次，第一次同时预热缓存；试运行失败时返回 256 x 64
+static int tuneTiles(Gray2MonoContext *context)
+{
+    static const int widths[] = {64, 128, 256, 512, 1024};
+    static const int heights[] = {16, 32, 64, 128, 256};
+    int best = (256 << 16) | 64;
+    double bestSeconds = -1;
+    size_t pixels = (size_t)TUNE_WIDTH * TUNE_HEIGHT;
+
+    unsigned char *image = (unsigned char *)malloc(pixels * 2);
+    if (!image)
+    {
+        return best;
+    }
+    unsigned int seed = 1;
+    for (size_t i = 0; i < pixels; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        image[i] = (unsigned char)(seed >> 24);
+    }
+
+    Gray2MonoImage src = {image, TUNE_WIDTH, TUNE_HEIGHT, TUNE_WIDTH, 8, NULL};
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+    settings.windowSize = TUNE_WINDOW;
+    settings.algorithm = GRAY2MONO_ALGORITHM_TILED;
+    BinarizeParams params;
+    if (imageParams(&params, &src, &image[pixels], TUNE_WIDTH, &settings) == GRAY2MONO_OK &&
+        reserveRows(&params, &context->scratch) == 0)
+    {
+        for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+        {
+            for (size_t h = 0; h < sizeof(heights) / sizeof(heights[0]); h++)
+            {
+                params.tileWidth = widths[w];
+                params.tileHeight = heights[h];
+                for (int repeat = 0; repeat < 2; repeat++)
+                {
+                    double start = monotonicSeconds();
+                    if (binarizeTiled(&params, 0, TUNE_HEIGHT, &context->scratch) != 0)
+                    {
+                        break;
+                    }
+                    double seconds = monotonicSeconds() - start;
+                    if (bestSeconds < 0 || seconds < bestSeconds)
+                    {
+                        bestSeconds = seconds;
+                        best = (widths[w] << 16) | heights[h];
+                    }
+                }
+            }
+        }
+    }
+
+    free(image);
+    return best;
+}
+
+void gray2monoTileSize(Gray2MonoContext *context, int *width, int *height)
+{
+    int size = atomic_load(&tileSize);
+    if (size == 0)
+    {
+        // 多个线程同时首次调用时各自试运行，无论保留哪一个结果都是有效的块大小
+        initKernels();
+        size = tuneTiles(context);
+        atomic_store(&tileSize, size);
+    }
+    *width = size >> 16;
+    *height = size & 0xFFFF;
+}
+
+int gray2monoSetTileSize(int width, int height)
+{
+    if (width <= 0 || width > 4096 || width % 16 != 0 || height <= 0 || height > 4096)
+    {
+        return GRAY2MONO_ERROR_SETTINGS;
+    }
+    atomic_store(&tileSize, (width << 16) | height);
+    return GRAY2MONO_OK;
+}
+
+int gray2monoBinarize(Gray2MonoContext *context, const Gray2MonoImage *src, unsigned char *dst, int dstStride,
+                      const Gray2MonoSettings *settings)
+{
+    BinarizeParams params;
+    int error = imageParams(&params, src, dst, dstStride, settings);
+    if (error != GRAY2MONO_OK)
+    {
+        return error;
+    }
+
+    initKernels();
+
+    // 自动阈值在写入输出之前求出，原地处理时直方图读到的仍是源图像
+    if (settings->method == GRAY2MONO_METHOD_MEAN && settings->threshold == GRAY2MONO_THRESHOLD_AUTO &&
+        (error = autoThreshold(context, src, &params.threshold)) != GRAY2MONO_OK)
+    {
+        return error;
+    }
+    if (settings->algorithm == GRAY2MONO_ALGORITHM_TILED)
+    {
+        gray2monoTileSize(context, &params.tileWidth, &params.tileHeight);
+    }
+
+    size_t srcSize = (size_t)src->stride * (src->height - 1) + (size_t)src->width * (src->bitCount / 8);
+    size_t dstSize = (size_t)dstStride * src->height;
+    if (dst < src->data + srcSize && src->data < dst + dstSize)
+    {
+        // 单线程的滑动窗口实现可以原地计算，不需要整图拷贝
+        // 输出行距不超过源行距时，输出的第 y 行不超过源第 y 行的末尾，而第 y 行及之前的源行此时都已读取
+        if (dst == src->data && dstStride <= src->stride && settings->threads <= 1 && settings->method == GRAY2MONO_METHOD_MEAN &&
+            settings->algorithm == GRAY2MONO_ALGORITHM_BOX && boxSupported(settings->windowSize) &&
+            reserveRows(&params, &context->scratch) == 0 && binarizeBox(&params, 0, params.height, &context->scratch) == 0)
+        {
+            return GRAY2MONO_OK;
+        }
+
+        // 其余情况先拷贝源图像，拷贝缓冲区在调用之间复用
+        if (reserveBuffer((void **)&context->copy, &context->copyCapacity, srcSize) != 0)
+        {
+            return GRAY2MONO_ERROR_MEMORY;
+        }
+        memcpy(context->copy, src->data, srcSize);
+        params.src = context->copy;
+    }
+
+    if (settings->threads > 1)
+    {
+        return binarizeThreaded(context, &params, settings->threads);
+    }
+    return binarizeRows(&params, 0, params.height, &context->scratch);
+}
+
+int gray2monoSweep(Gray2MonoContext *context, const Gray2MonoImage *src, const int *thresholds, int thresholdCount,
+                   const int *windowSizes, int windowCount, unsigned char *const *dsts, int dstStride,
+                   unsigned long long *foreground, const Gray2MonoSettings *settings)
+{
+    if (thresholdCount <= 0 || windowCount <= 0)
+    {
+        return GRAY2MONO_ERROR_SETTINGS;
+    }
+    if (settings->method != GRAY2MONO_METHOD_MEAN)
+    {
+        return GRAY2MONO_ERROR_SWEEP_METHOD;
+    }
+
+    // 逐个检查每个阈值与窗口，最大的窗口决定积分图的光晕与条带高度
+    Gray2MonoSettings checked = *settings;
+    int maxWindow = 0;
+    for (int t = 0; t < thresholdCount; t++)
+    {
+        checked.threshold = thresholds[t];
+        for (int w = 0; w < windowCount; w++)
+        {
+            checked.windowSize = windowSizes[w];
+            int error = gray2monoCheckSettings(&checked, src->width, src->height);
+            if (error != GRAY2MONO_OK)
+            {
+                return error;
+            }
+            maxWindow = windowSizes[w] > maxWindow ? windowSizes[w] : maxWindow;
+        }
+    }
+
+    BinarizeParams params;
+    checked.windowSize = maxWindow;
+    int error = imageParams(&params, src, dsts[0], dstStride, &checked);
+    if (error != GRAY2MONO_OK)
+    {
+        return error;
+    }
+
+    size_t combinations = (size_t)thresholdCount * windowCount;
+    if (reserveBuffer((void **)&context->counts, &context->countsCapacity, combinations * sizeof(atomic_ullong)) != 0)
+    {
+        return GRAY2MONO_ERROR_MEMORY;
+    }
+    for (size_t i = 0; i < combinations; i++)
+    {
+        atomic_init(&context->counts[i], 0);
+    }
+    initKernels();
+
+    // 列表中的自动阈值替换为同一个 Otsu 阈值
+    for (int t = 0; t < thresholdCount; t++)
+    {
+        if (thresholds[t] != GRAY2MONO_THRESHOLD_AUTO)
+        {
+            continue;
+        }
+        int otsu;
+        if ((error = autoThreshold(context, src, &otsu)) != GRAY2MONO_OK ||
+            reserveBuffer((void **)&context->thresholds, &context->thresholdsCapacity, thresholdCount * sizeof(int)) != 0)
+        {
+            return error != GRAY2MONO_OK ? error : GRAY2MONO_ERROR_MEMORY;
+        }
+        for (int i = 0; i < thresholdCount; i++)
+        {
+            context->thresholds[i] = thresholds[i] == GRAY2MONO_THRESHOLD_AUTO ? otsu : thresholds[i];
+        }
+        thresholds = context->thresholds;
+        break;
+    }
+
+    params.dsts = dsts;
+    params.thresholds = thresholds;
+    params.thresholdCount = thresholdCount;
+    params.windowSizes = windowSizes;
+    params.windowCount = windowCount;
+    params.counts = foreground ? context->counts : NULL;
+
+    // 单线程时也分条带处理，使积分图保持在约 SWEEP_BAND_BYTES 内，条带不低于最大窗口以控制光晕的重复计算
+    int bandHeight = (int)(SWEEP_BAND_BYTES / (((size_t)params.width + 1) * sizeof(unsigned long long)));
+    int threads = settings->threads > 1 ? settings->threads : 1;
+    int balanced = (params.height + threads * 4 - 1) / (threads * 4);
+    bandHeight = bandHeight < balanced ? bandHeight : balanced;
+    bandHeight = bandHeight > maxWindow ? bandHeight : maxWindow;
+    error = binarizeBands(context, &params, threads, bandHeight);
+    for (size_t i = 0; foreground && i < combinations; i++)
+    {
+        foreground[i] = atomic_load(&context->counts[i]);
+    }
+    return error;
+}
+
+int gray2monoStreamBegin(Gray2MonoContext *context, const Gray2MonoImage *format, const Gray2MonoSettings *settings)
+{
+    BinarizeParams *params = &context->streamParams;
+    size_t rowSize = gray2monoRowSize(format->width, settings->bitCount);
+    int error = imageParams(params, format, NULL, (int)rowSize, settings);
+    if (error != GRAY2MONO_OK)
+    {
+        return error;
+    }
+    if (settings->method != GRAY2MONO_METHOD_MEAN)
+    {
+        return GRAY2MONO_ERROR_STREAM_METHOD;
+    }
+    if (!boxSupported(settings->windowSize))
+    {
+        return GRAY2MONO_ERROR_STREAM_WINDOW;
+    }
+    if (settings->threshold == GRAY2MONO_THRESHOLD_AUTO)
+    {
+        return GRAY2MONO_ERROR_STREAM_THRESHOLD;
+    }
+
+    // 环形缓冲、列和与一行 0；灰度行、8 位输出行与打包后的输出行
+    int width = format->width;
+    int ringSize = settings->windowSize + 1;
+    size_t outSize = gray2monoRowSize(width, 8);
+    if (reserveBuffer(&context->stream.work, &context->stream.workCapacity, (size_t)width * (ringSize + 2) * sizeof(unsigned int)) != 0 ||
+        reserveBuffer((void **)&context->stream.rows, &context->stream.rowsCapacity, width + outSize + rowSize) != 0)
+    {
+        return GRAY2MONO_ERROR_MEMORY;
+    }
+    memset((unsigned int *)context->stream.work + (size_t)width * ringSize, 0, (size_t)width * 2 * sizeof(unsigned int));
+    memset(context->stream.rows + width, 0, outSize);
+    params->dst = context->stream.rows + width + outSize;
+    context->streamRow = 0;
+    context->streamOut = 0;
+
+    initKernels();
+    return GRAY2MONO_OK;
+}
+
+// 读入第 r 行后第 r - halfWindow 行的窗口凑齐，此时更新列和并输出该行
+// BMP 默认自下而上存储，窗口上下对称，按存储顺序处理与按图像行序处理结果相同
+const unsigned char *gray2monoStreamRow(Gray2MonoContext *context, const unsigned char *row)
+{
+    const BinarizeParams *params = &context->streamParams;
+    int width = params->width, height = params->height, windowSize = params->windowSize;
+    int halfWindow = windowSize / 2;
+    int ringSize = windowSize + 1;
+    unsigned int *ring = (unsigned int *)context->stream.work;
+    unsigned int *colSums = &ring[(size_t)width * ringSize];
+    unsigned int *zeros = &ring[(size_t)width * (ringSize + 1)];
+    unsigned char *gray = context->stream.rows;
+    unsigned char *outRow = gray + width;
+
+    if (context->streamOut >= height || (context->streamRow < height && !row))
+    {
+        return NULL;
+    }
+
+    int r = context->streamRow++;
+    const unsigned int *add = zeros;
+    if (r < height)
+    {
+        unsigned int *rowSums = &ring[(size_t)(r % ringSize) * width];
+        boxRowSums(convertRow(row, gray, width, params->srcBitCount, params->lut), rowSums, width, halfWindow);
+        add = rowSums;
+    }
+
+    int y = r - halfWindow;
+    if (y < 0)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            colSums[x] += add[x];
+        }
+        return NULL;
+    }
+
+    int leave = y - halfWindow - 1;
+    const unsigned int *sub = leave >= 0 ? &ring[(size_t)(leave % ringSize) * width] : zeros;
+    boxOutputRow(colSums, add, sub, outRow, y, width, height, params->threshold, windowSize);
+    context->streamOut++;
+
+    // 1 位输出时打包后返回
+    if (params->bitCount == 1)
+    {
+        finishRow(params, outRow, 0);
+        return params->dst;
+    }
+    return outRow;
+}
+
+int gray2monoParseBmpHeader(const unsigned char *header, Gray2MonoBmp *bmp)
+{
+    memcpy(&bmp->fHeader, header, sizeof(BmpFileHeader));
+    memcpy(&bmp->iHeader, header + sizeof(BmpFileHeader), sizeof(BmpInfoHeader));
+
+    bmp->width = bmp->iHeader.biWidth;
+    bmp->height = abs(bmp->iHeader.biHeight);
+    bmp->bitCount = bmp->iHeader.biBitCount;
+
+    // 文件位深检测
+    if (bmp->bitCount != 8 && bmp->bitCount != 24 && bmp->bitCount != 32)
+    {
+        return GRAY2MONO_ERROR_FORMAT;
+    }
+    if (bmp->iHeader.biCompression != 0)
+    {
+        return GRAY2MONO_ERROR_COMPRESSED;
+    }
+
+    // 调色板紧跟信息头（信息头可能比 BmpInfoHeader 长），数量由 biClrUsed 给出，0 表示 256；像素从 bfOffBits 开始
+    bmp->rowSize = gray2monoRowSize(bmp->width, bmp->bitCount);
+    bmp->paletteOffset = sizeof(BmpFileHeader) + bmp->iHeader.biSize;
+    bmp->paletteCount = 0;
+    if (bmp->bitCount == 8)
+    {
+        bmp->paletteCount = bmp->iHeader.biClrUsed == 0 || bmp->iHeader.biClrUsed > 256 ? 256 : (int)bmp->iHeader.biClrUsed;
+    }
+    bmp->pixelOffset = bmp->fHeader.bfOffBits;
+    bmp->identityLut = bmp->bitCount == 8;
+    if (bmp->width <= 0 || bmp->height <= 0 || bmp->iHeader.biSize < sizeof(BmpInfoHeader) ||
+        bmp->pixelOffset < bmp->paletteOffset + sizeof(BmpRgbQuad) * bmp->paletteCount)
+    {
+        return GRAY2MONO_ERROR_INVALID_HEADER;
+    }
+    return GRAY2MONO_OK;
+}
+
+// 由调色板建立索引到灰度的查找表，数量之外的索引视为黑色
+void gray2monoParseBmpPalette(const unsigned char *palette, Gray2MonoBmp *bmp)
+{
+    bmp->identityLut = bmp->paletteCount == 256;
+    for (int i = 0; i < 256; i++)
+    {
+        const unsigned char *entry = &palette[i * sizeof(BmpRgbQuad)];
+        bmp->lut[i] = i < bmp->paletteCount ? luma(entry[2], entry[1], entry[0]) : 0;
+        bmp->identityLut = bmp->identityLut && bmp->lut[i] == i;
+    }
+}
+
+int gray2monoDecodeBmp(const unsigned char *data, size_t size, Gray2MonoBmp *bmp)
+{
+    // 信息头文件头获取
+    if (size < sizeof(BmpFileHeader) + sizeof(BmpInfoHeader))
+    {
+        return GRAY2MONO_ERROR_HEADER;
+    }
+    int error = gray2monoParseBmpHeader(data, bmp);
+    if (error != GRAY2MONO_OK)
+    {
+        return error;
+    }
+
+    if (bmp->pixelOffset > size || size - bmp->pixelOffset < bmp->rowSize * bmp->height)
+    {
+        return GRAY2MONO_ERROR_DATA;
+    }
+    if (bmp->bitCount == 8)
+    {
+        gray2monoParseBmpPalette(data + bmp->paletteOffset, bmp);
+    }
+    return GRAY2MONO_OK;
+}
+
+void gray2monoBmpImage(const Gray2MonoBmp *bmp, const unsigned char *pixels, Gray2MonoImage *image)
+{
+    image->data = pixels;
+    image->width = bmp->width;
+    image->height = bmp->height;
+    image->stride = (int)bmp->rowSize;
+    image->bitCount = bmp->bitCount;
+    image->lut = bmp->bitCount == 8 && !bmp->identityLut ? bmp->lut : NULL;
+}
+
+// 设置二值化后的调色板
+static void grayPalette(BmpRgbQuad *palette, int paletteCount)
+{
+    for (int i = 0; i < paletteCount; i++)
+    {
+        palette[i].rgbBlue = palette[i].rgbGreen = palette[i].rgbRed = i;
+        palette[i].rgbReserved = 0;
+    }
+}
+
+// 8 位输出为 256 级灰度调色板，1 位输出为 2 色调色板（0 黑 1 白）
+// 标准布局的 8 位输入输出为 8 位时沿用输入的文件头与信息头，其余情况重新计算各尺寸字段
+void gray2monoBmpLayout(Gray2MonoLayout *layout, const Gray2MonoBmp *bmp, int bitCount)
+{
+    layout->fHeader = bmp->fHeader;
+    layout->iHeader = bmp->iHeader;
+    layout->rowSize = gray2monoRowSize(bmp->width, bitCount);
+    layout->paletteCount = bitCount == 1 ? 2 : 256;
+    layout->headerSize = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader) + sizeof(BmpRgbQuad) * layout->paletteCount;
+    layout->fileSize = layout->headerSize + layout->rowSize * bmp->height;
+    grayPalette(layout->palette, layout->paletteCount);
+    if (bitCount == 1)
+    {
+        // 调色板索引 0 为黑，1 为白，与 8 位输出的 0/255 对应
+        layout->palette[1].rgbBlue = layout->palette[1].rgbGreen = layout->palette[1].rgbRed = 255;
+    }
+
+    if (bitCount == 8 && bmp->bitCount == 8 && bmp->iHeader.biSize == sizeof(BmpInfoHeader) &&
+        bmp->pixelOffset == layout->headerSize)
+    {
+        return;
+    }
+    layout->fHeader.bfSize = (unsigned int)layout->fileSize;
+    layout->fHeader.bfOffBits = (unsigned int)layout->headerSize;
+    layout->iHeader.biSize = sizeof(BmpInfoHeader);
+    layout->iHeader.biBitCount = (unsigned short)bitCount;
+    layout->iHeader.biCompression = 0;
+    layout->iHeader.biSizeImage = (unsigned int)(layout->rowSize * bmp->height);
+    layout->iHeader.biClrUsed = (unsigned int)layout->paletteCount;
+    layout->iHeader.biClrImportant = 0;
+}
+
+void gray2monoEncodeBmpHeader(unsigned char *data, const Gray2MonoLayout *layout)
+{
+    memcpy(data, &layout->fHeader, sizeof(BmpFileHeader));
+    memcpy(data + sizeof(BmpFileHeader), &layout->iHeader, sizeof(BmpInfoHeader));
+    memcpy(data + sizeof(BmpFileHeader) + sizeof(BmpInfoHeader), layout->palette, sizeof(BmpRgbQuad) * layout->paletteCount);
+}
+
+int gray2monoBinarizeBmp(Gray2MonoContext *context, const unsigned char *data, size_t size,
+                         unsigned char *out, size_t capacity, size_t *outSize, const Gray2MonoSettings *settings)
+{
+    Gray2MonoBmp bmp;
+    int error = gray2monoDecodeBmp(data, size, &bmp);
+    if (error == GRAY2MONO_OK)
+    {
+        error = gray2monoCheckSettings(settings, bmp.width, bmp.height);
+    }
+    if (error != GRAY2MONO_OK)
+    {
+        return error;
+    }
+
+    Gray2MonoLayout layout;
+    gray2monoBmpLayout(&layout, &bmp, settings->bitCount);
+    *outSize = layout.fileSize;
+    if (capacity < layout.fileSize)
+    {
+        return GRAY2MONO_ERROR_BUFFER;
+    }
+
+    Gray2MonoImage image;
+    gray2monoBmpImage(&bmp, data + bmp.pixelOffset, &image);
+    gray2monoEncodeBmpHeader(out, &layout);
+    return gray2monoBinarize(context, &image, out + layout.headerSize, (int)layout.rowSize, settings);
+}
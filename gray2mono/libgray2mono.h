@@ -0,0 +1,178 @@
+#ifndef LIBGRAY2MONO_H
+#define LIBGRAY2MONO_H
+
+#include <stddef.h>
+#include "bmp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 二值化算法
+enum
+{
+    GRAY2MONO_ALGORITHM_NAIVE,
+    GRAY2MONO_ALGORITHM_INTEGRAL,
+    GRAY2MONO_ALGORITHM_BOX,
+    GRAY2MONO_ALGORITHM_TILED
+};
+
+// 阈值方法
+enum
+{
+    GRAY2MONO_METHOD_MEAN,     // 窗口均值与固定阈值比较
+    GRAY2MONO_METHOD_NIBLACK,  // 像素与 m + k * s 比较
+    GRAY2MONO_METHOD_SAUVOLA   // 像素与 m * (1 + k * (s / R - 1)) 比较
+};
+
+// 返回值，0 表示成功
+enum
+{
+    GRAY2MONO_OK,
+    GRAY2MONO_ERROR_HEADER,
+    GRAY2MONO_ERROR_INVALID_HEADER,
+    GRAY2MONO_ERROR_FORMAT,
+    GRAY2MONO_ERROR_COMPRESSED,
+    GRAY2MONO_ERROR_DATA,
+    GRAY2MONO_ERROR_THRESHOLD,
+    GRAY2MONO_ERROR_WINDOW,
+    GRAY2MONO_ERROR_SETTINGS,
+    GRAY2MONO_ERROR_STREAM_METHOD,
+    GRAY2MONO_ERROR_STREAM_WINDOW,
+    GRAY2MONO_ERROR_BUFFER,
+    GRAY2MONO_ERROR_MEMORY,
+    GRAY2MONO_ERROR_SWEEP_METHOD,
+    GRAY2MONO_ERROR_STREAM_THRESHOLD
+};
+
+// 阈值取此值时按 Otsu 方法由整幅图像的灰度直方图自动选择
+enum
+{
+    GRAY2MONO_THRESHOLD_AUTO = -1
+};
+
+// 二值化参数
+typedef struct
+{
+    int threshold;  // 均值方法的阈值，0~255 或 GRAY2MONO_THRESHOLD_AUTO
+    int windowSize; // 窗口大小，奇数且不超过图像宽高
+    int algorithm;
+    int method;
+    double k;       // Niblack 与 Sauvola 的 k
+    double r;       // Sauvola 的 R
+    int bitCount;   // 输出位深，8 为每像素一字节 0/255，1 为每 8 个像素一字节
+    int threads;    // 线程数，1 为在调用线程上处理
+} Gray2MonoSettings;
+
+// 输入图像，行按存储顺序排列
+typedef struct
+{
+    const unsigned char *data;
+    int width;
+    int height;
+    int stride;               // 相邻两行的字节距离，必须为正，不支持以负行距表示的自下而上布局
+    int bitCount;             // 8 位索引或 24/32 位 BGR(A)
+    const unsigned char *lut; // 8 位图像索引对应的灰度，NULL 表示像素值即为灰度
+} Gray2MonoImage;
+
+// 解析后的 BMP 文件
+typedef struct
+{
+    BmpFileHeader fHeader;
+    BmpInfoHeader iHeader;
+    int width;
+    int height;
+    int bitCount;
+    size_t rowSize;
+    size_t paletteOffset;
+    int paletteCount;
+    size_t pixelOffset;
+    int identityLut;        // 调色板为 0..255 的灰度，像素值即为灰度
+    unsigned char lut[256]; // 8 位图像调色板索引对应的灰度
+} Gray2MonoBmp;
+
+// 输出 BMP 文件的文件头、信息头、调色板与尺寸
+typedef struct
+{
+    BmpFileHeader fHeader;
+    BmpInfoHeader iHeader;
+    BmpRgbQuad palette[256];
+    int paletteCount;
+    size_t rowSize;
+    size_t headerSize;
+    size_t fileSize;
+} Gray2MonoLayout;
+
+// 持有可复用缓冲区的上下文，缓冲区只在图像变大时重新分配
+// 同一个上下文不能同时在多个线程中使用，每个线程使用各自的上下文
+typedef struct Gray2MonoContext Gray2MonoContext;
+
+// 默认参数：阈值 128，窗口 3，滑动窗口算法，均值方法，8 位输出，单线程
+void gray2monoDefaultSettings(Gray2MonoSettings *settings);
+
+// 错误码对应的说明
+const char *gray2monoErrorString(int error);
+
+// 获取硬件线程数
+int gray2monoHardwareConcurrency(void);
+
+// 行宽按 4 字节对齐
+size_t gray2monoRowSize(int width, int bitCount);
+
+// 检查参数是否适用于 width x height 的图像
+int gray2monoCheckSettings(const Gray2MonoSettings *settings, int width, int height);
+
+Gray2MonoContext *gray2monoCreate(void);
+void gray2monoDestroy(Gray2MonoContext *context);
+
+// 将 src 二值化到 dst，dst 的行距为 dstStride（必须为正），行尾的补位填充 0
+// dst 可以与 src 重叠；与 src->data 相同且 dstStride 不超过 src->stride 时原地处理
+int gray2monoBinarize(Gray2MonoContext *context, const Gray2MonoImage *src, unsigned char *dst, int dstStride,
+                      const Gray2MonoSettings *settings);
+
+// 分块算法的块大小（像素），首次调用时在一张小图上试运行各候选大小，选出最快的并在进程内缓存
+void gray2monoTileSize(Gray2MonoContext *context, int *width, int *height);
+// 直接设置块大小，跳过试运行，可用于恢复上次保存的结果；width 为 16 的倍数，两者都不超过 4096
+int gray2monoSetTileSize(int width, int height);
+
+// 累加 src 中 [y0, y1) 行灰度的直方图，histogram 由调用者清零，可以分多次调用逐段累加
+int gray2monoHistogram(Gray2MonoContext *context, const Gray2MonoImage *src, int y0, int y1, unsigned long long histogram[256]);
+// Otsu 方法：返回使两类（灰度不超过阈值与大于阈值）类间方差最大的阈值，只有一种灰度时返回 0
+int gray2monoOtsu(const unsigned long long histogram[256]);
+
+// 参数扫描：只支持均值方法，所有窗口共用一张积分图，每个窗口的均值在同一次遍历中与所有阈值比较
+// dsts[w * thresholdCount + t] 为 windowSizes[w] 与 thresholds[t] 组合的输出，行距均为 dstStride，不能与 src 重叠
+// foreground 不为 NULL 时返回各输出中前景（黑色）像素的数量
+int gray2monoSweep(Gray2MonoContext *context, const Gray2MonoImage *src, const int *thresholds, int thresholdCount,
+                   const int *windowSizes, int windowCount, unsigned char *const *dsts, int dstStride,
+                   unsigned long long *foreground, const Gray2MonoSettings *settings);
+
+// 流式二值化：只支持均值方法与固定阈值，内存占用与图像高度无关
+// 列和为 32 位，窗口大小不超过 2895，更大的窗口返回 GRAY2MONO_ERROR_STREAM_WINDOW
+// 开始后按存储顺序逐行送入源行，全部送入后以 NULL 继续调用，每次返回下一个完成的输出行，窗口未凑齐时返回 NULL
+// 输出行按 gray2monoRowSize(width, bitCount) 对齐，在下一次调用前有效
+int gray2monoStreamBegin(Gray2MonoContext *context, const Gray2MonoImage *format, const Gray2MonoSettings *settings);
+const unsigned char *gray2monoStreamRow(Gray2MonoContext *context, const unsigned char *row);
+
+// 解析文件开头的文件头与信息头，header 为 sizeof(BmpFileHeader) + sizeof(BmpInfoHeader) 字节
+int gray2monoParseBmpHeader(const unsigned char *header, Gray2MonoBmp *bmp);
+// 由 paletteOffset 处的调色板建立灰度表
+void gray2monoParseBmpPalette(const unsigned char *palette, Gray2MonoBmp *bmp);
+// 解析内存中的整个 BMP 文件
+int gray2monoDecodeBmp(const unsigned char *data, size_t size, Gray2MonoBmp *bmp);
+// 由解析结果与像素数据得到输入图像
+void gray2monoBmpImage(const Gray2MonoBmp *bmp, const unsigned char *pixels, Gray2MonoImage *image);
+
+// 计算输出文件的布局，并向内存写入文件头、信息头与调色板
+void gray2monoBmpLayout(Gray2MonoLayout *layout, const Gray2MonoBmp *bmp, int bitCount);
+void gray2monoEncodeBmpHeader(unsigned char *data, const Gray2MonoLayout *layout);
+
+// 内存到内存处理整个 BMP 文件，outSize 返回输出大小，capacity 不足时返回 GRAY2MONO_ERROR_BUFFER
+int gray2monoBinarizeBmp(Gray2MonoContext *context, const unsigned char *data, size_t size,
+                         unsigned char *out, size_t capacity, size_t *outSize, const Gray2MonoSettings *settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
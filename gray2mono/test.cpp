@@ -0,0 +1,773 @@
+/**
+ * Bit-exactness harness and benchmark for libgray2mono.
+ *
+ *      gcc -O2 -c libgray2mono.c -o libgray2mono.o
+ *      g++ -std=c++17 -O2 test.cpp libgray2mono.o -o test -pthread
+ *      ./test [benchmark width, default 4096, 0 skips the benchmark] [seed]
+ *
+ * Synthetic 8-bit BMPs of many sizes are generated in memory, including odd
+ * widths whose rows end in padding and windows up to the image size. Every
+ * path (naive, integral, box and tiled engines, threaded bands, in-place,
+ * 1-bit output, the BMP codec, streaming and the sweep) must produce
+ * byte-identical output to the single-threaded naive loop, padding included.
+ * The tiled engine runs with tiny tiles so that tile seams and halos land
+ * inside even the smallest images. The histogram
+ * and the automatic (Otsu) threshold are checked against a plain count.
+ * Each image is also re-encoded as 24-bit, 32-bit or shuffled-palette 8-bit
+ * with the same luma, which must give the same output on every path, and
+ * Niblack and Sauvola are checked against a plain per-window computation.
+ * Zero and negative strides must be rejected by every entry point.
+ *
+ * The benchmark then reports megapixels/s per path and thread count, with
+ * the tiled engine using the auto-tuned tile size; each measurement is also
+ * timed with AutoTimer.
+ */
+
+#include "libgray2mono.h"
+#include "../timer/timer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 内存中的 8 位灰度 BMP 文件
+struct Bitmap
+{
+    std::vector<unsigned char> file;
+    Gray2MonoBmp bmp;
+    Gray2MonoImage image;
+};
+
+// 像素内容：噪声、渐变、常数与两级图像，常数与两级图像的窗口均值常常恰好为整数
+enum Pattern
+{
+    NOISE,
+    GRADIENT,
+    CONSTANT,
+    TWO_LEVEL,
+    PATTERN_COUNT
+};
+
+static Bitmap makeBitmap(int width, int height, Pattern pattern, std::mt19937 &gen)
+{
+    Bitmap b;
+    size_t rowSize = gray2monoRowSize(width, 8);
+    size_t headerSize = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader) + 256 * sizeof(BmpRgbQuad);
+    b.file.assign(headerSize + rowSize * height, 0);
+
+    BmpFileHeader fHeader = {0x4D42, (unsigned int)b.file.size(), 0, 0, (unsigned int)headerSize};
+    BmpInfoHeader iHeader = {sizeof(BmpInfoHeader), width, height, 1, 8, 0, (unsigned int)(rowSize * height), 0, 0, 256, 0};
+    std::memcpy(&b.file[0], &fHeader, sizeof(fHeader));
+    std::memcpy(&b.file[sizeof(fHeader)], &iHeader, sizeof(iHeader));
+    for (int i = 0; i < 256; i++)
+    {
+        BmpRgbQuad entry = {(unsigned char)i, (unsigned char)i, (unsigned char)i, 0};
+        std::memcpy(&b.file[sizeof(fHeader) + sizeof(iHeader) + i * sizeof(BmpRgbQuad)], &entry, sizeof(entry));
+    }
+
+    std::uniform_int_distribution<int> dis(0, 255);
+    int level = dis(gen), low = dis(gen), high = dis(gen);
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char *row = &b.file[headerSize + rowSize * y];
+        for (int x = 0; x < width; x++)
+        {
+            switch (pattern)
+            {
+            case NOISE: row[x] = (unsigned char)dis(gen); break;
+            case GRADIENT: row[x] = (unsigned char)((x * 7 + y * 3 + dis(gen) % 16) & 255); break;
+            case CONSTANT: row[x] = (unsigned char)level; break;
+            default: row[x] = (unsigned char)(dis(gen) & 1 ? high : low); break;
+            }
+        }
+        // 补位填充非 0 的值，任何路径都不应读取它们
+        std::fill(row + width, row + rowSize, 0xAB);
+    }
+
+    gray2monoDecodeBmp(b.file.data(), b.file.size(), &b.bmp);
+    gray2monoBmpImage(&b.bmp, &b.file[b.bmp.pixelOffset], &b.image);
+    return b;
+}
+
+// 亮度为 level 的随机颜色（BGR），随机若干次都不满足时退回灰色
+static void colorFor(int level, std::mt19937 &gen, unsigned char *bgr)
+{
+    std::uniform_int_distribution<int> dis(0, 255);
+    for (int attempt = 0; attempt < 8; attempt++)
+    {
+        int red = dis(gen), blue = dis(gen);
+        int rest = level * 128 - 64 - red * 38 - blue * 15;
+        int green = rest <= 0 ? 0 : (rest + 74) / 75;
+        if (green <= 255 && (red * 38 + green * 75 + blue * 15 + 64) >> 7 == level)
+        {
+            bgr[0] = (unsigned char)blue, bgr[1] = (unsigned char)green, bgr[2] = (unsigned char)red;
+            return;
+        }
+    }
+    bgr[0] = bgr[1] = bgr[2] = (unsigned char)level;
+}
+
+// 与灰度图像逐像素亮度相同的 24 位、32 位或调色板 8 位 BMP，参考输出与灰度图像的相同
+// 调色板为随机排列的彩色，亮度查找表不是恒等映射
+static Bitmap recolor(const Bitmap &gray, int bitCount, std::mt19937 &gen)
+{
+    Bitmap b;
+    int width = gray.image.width, height = gray.image.height;
+    int paletteCount = bitCount == 8 ? 256 : 0;
+    size_t rowSize = gray2monoRowSize(width, bitCount);
+    size_t headerSize = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader) + paletteCount * sizeof(BmpRgbQuad);
+    b.file.assign(headerSize + rowSize * height, 0);
+
+    BmpFileHeader fHeader = {0x4D42, (unsigned int)b.file.size(), 0, 0, (unsigned int)headerSize};
+    BmpInfoHeader iHeader = {sizeof(BmpInfoHeader), width, height, 1, (unsigned short)bitCount, 0,
+                                (unsigned int)(rowSize * height), 0, 0, (unsigned int)paletteCount, 0};
+    std::memcpy(&b.file[0], &fHeader, sizeof(fHeader));
+    std::memcpy(&b.file[sizeof(fHeader)], &iHeader, sizeof(iHeader));
+
+    // index[v] 为亮度 v 所在的调色板项
+    std::vector<int> index(256);
+    for (int i = 0; i < 256; i++)
+    {
+        index[i] = i;
+    }
+    std::shuffle(index.begin(), index.end(), gen);
+    for (int level = 0; level < paletteCount; level++)
+    {
+        unsigned char *entry = &b.file[sizeof(fHeader) + sizeof(iHeader) + index[level] * sizeof(BmpRgbQuad)];
+        colorFor(level, gen, entry);
+    }
+
+    int bytes = bitCount / 8;
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *src = gray.image.data + (size_t)gray.image.stride * y;
+        unsigned char *row = &b.file[headerSize + rowSize * y];
+        for (int x = 0; x < width; x++)
+        {
+            if (bitCount == 8)
+            {
+                row[x] = (unsigned char)index[src[x]];
+            }
+            else
+            {
+                colorFor(src[x], gen, &row[x * bytes]);
+                if (bytes == 4)
+                {
+                    row[x * bytes + 3] = 0x5A;
+                }
+            }
+        }
+        std::fill(row + (size_t)width * bytes, row + rowSize, 0xAB);
+    }
+
+    gray2monoDecodeBmp(b.file.data(), b.file.size(), &b.bmp);
+    gray2monoBmpImage(&b.bmp, &b.file[b.bmp.pixelOffset], &b.image);
+    return b;
+}
+
+static int failures = 0;
+
+static void fail(const std::string &path, const Gray2MonoImage &image, const Gray2MonoSettings &settings)
+{
+    if (failures++ < 20)
+    {
+        std::cerr << "Mismatch in " << path << ": " << image.width << "x" << image.height
+                  << " r=" << settings.windowSize << " t=" << settings.threshold << std::endl;
+    }
+}
+
+// 将 8 位参考输出打包为 1 位，白色为 1，行尾补 0
+static std::vector<unsigned char> packReference(const std::vector<unsigned char> &reference, int width, int height)
+{
+    size_t rowSize = gray2monoRowSize(width, 8), packedSize = gray2monoRowSize(width, 1);
+    std::vector<unsigned char> packed(packedSize * height, 0);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if (reference[rowSize * y + x])
+            {
+                packed[packedSize * y + x / 8] |= (unsigned char)(0x80 >> (x % 8));
+            }
+        }
+    }
+    return packed;
+}
+
+// 单线程朴素实现的参考输出，顺序与参数扫描一致：窗口在外层，阈值在内层
+static std::vector<std::vector<unsigned char>> references(Gray2MonoContext *context, const Bitmap &b,
+                                                          const std::vector<int> &thresholds, const std::vector<int> &windowSizes)
+{
+    size_t rowSize = gray2monoRowSize(b.image.width, 8);
+    std::vector<std::vector<unsigned char>> outputs;
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+    settings.algorithm = GRAY2MONO_ALGORITHM_NAIVE;
+    for (int windowSize : windowSizes)
+    {
+        for (int threshold : thresholds)
+        {
+            settings.windowSize = windowSize;
+            settings.threshold = threshold;
+            outputs.emplace_back(rowSize * b.image.height, 0xCD);
+            if (gray2monoBinarize(context, &b.image, outputs.back().data(), (int)rowSize, &settings) != GRAY2MONO_OK)
+            {
+                fail("naive", b.image, settings);
+            }
+        }
+    }
+    return outputs;
+}
+
+// 对同一组参数运行所有路径，与参考输出逐字节比较
+static void checkPaths(Gray2MonoContext *context, const Bitmap &b, Gray2MonoSettings settings, const std::vector<unsigned char> &reference)
+{
+    const Gray2MonoImage &image = b.image;
+    int width = image.width, height = image.height;
+    size_t rowSize = gray2monoRowSize(width, 8);
+
+    // 参考输出本身即为单线程朴素实现，朴素实现只需再检查多线程
+    const struct
+    {
+        const char *name;
+        int algorithm;
+        int threads;
+    } engines[] = {{"naive", GRAY2MONO_ALGORITHM_NAIVE, 3},
+                   {"integral", GRAY2MONO_ALGORITHM_INTEGRAL, 1}, {"integral", GRAY2MONO_ALGORITHM_INTEGRAL, 3},
+                   {"box", GRAY2MONO_ALGORITHM_BOX, 1}, {"box", GRAY2MONO_ALGORITHM_BOX, 3},
+                   {"tiled", GRAY2MONO_ALGORITHM_TILED, 1}, {"tiled", GRAY2MONO_ALGORITHM_TILED, 3}};
+    std::vector<unsigned char> output;
+    for (auto &engine : engines)
+    {
+        // 朴素实现为 O(r^2)，多线程的条带划分在小窗口下已充分覆盖
+        if (engine.algorithm == GRAY2MONO_ALGORITHM_NAIVE && settings.windowSize > 31)
+        {
+            continue;
+        }
+        settings.algorithm = engine.algorithm;
+        settings.threads = engine.threads;
+        std::string name = std::string(engine.name) + " j=" + std::to_string(engine.threads);
+
+        settings.bitCount = 8;
+        output.assign(rowSize * height, 0xCD);
+        if (gray2monoBinarize(context, &image, output.data(), (int)rowSize, &settings) != GRAY2MONO_OK || output != reference)
+        {
+            fail(name, image, settings);
+        }
+
+        // 1 位输出在各条带内打包，只检查较快的引擎的多线程；分块引擎按块分段打包
+        if (engine.threads > 1 && engine.algorithm != GRAY2MONO_ALGORITHM_NAIVE)
+        {
+            settings.bitCount = 1;
+            size_t packedSize = gray2monoRowSize(width, 1);
+            output.assign(packedSize * height, 0xCD);
+            if (gray2monoBinarize(context, &image, output.data(), (int)packedSize, &settings) != GRAY2MONO_OK ||
+                output != packReference(reference, width, height))
+            {
+                fail(name + " 1-bit", image, settings);
+            }
+        }
+    }
+
+    // 原地处理：输出写回源图像的像素区，单线程的滑动窗口实现不经过拷贝，8 位与 1 位输出都检查
+    settings.algorithm = GRAY2MONO_ALGORITHM_BOX;
+    settings.threads = 1;
+    for (int bitCount : {8, 1})
+    {
+        settings.bitCount = bitCount;
+        std::vector<unsigned char> expected = bitCount == 8 ? reference : packReference(reference, width, height);
+        std::vector<unsigned char> inPlace(b.file.begin() + b.bmp.pixelOffset, b.file.end());
+        Gray2MonoImage inPlaceImage = image;
+        inPlaceImage.data = inPlace.data();
+        if (gray2monoBinarize(context, &inPlaceImage, inPlace.data(), (int)gray2monoRowSize(width, bitCount), &settings) != GRAY2MONO_OK ||
+            !std::equal(expected.begin(), expected.end(), inPlace.begin()))
+        {
+            fail(bitCount == 8 ? "in-place" : "in-place 1-bit", image, settings);
+        }
+    }
+
+    // 整个 BMP 文件的内存到内存处理
+    settings.threads = 2;
+    settings.bitCount = 8;
+    size_t outSize = 0;
+    Gray2MonoLayout layout;
+    gray2monoBmpLayout(&layout, &b.bmp, 8);
+    std::vector<unsigned char> file(layout.fileSize);
+    if (gray2monoBinarizeBmp(context, b.file.data(), b.file.size(), file.data(), file.size(), &outSize, &settings) != GRAY2MONO_OK ||
+        outSize != layout.fileSize || !std::equal(reference.begin(), reference.end(), file.begin() + layout.headerSize))
+    {
+        fail("bmp", image, settings);
+    }
+
+    // 流式处理：全部送入后以 NULL 取出剩余的行
+    settings.threads = 1;
+    if (gray2monoStreamBegin(context, &image, &settings) == GRAY2MONO_OK)
+    {
+        output.clear();
+        for (int y = 0; y < height || (int)output.size() < (int)rowSize * height; y++)
+        {
+            const unsigned char *row = gray2monoStreamRow(context, y < height ? image.data + (size_t)image.stride * y : nullptr);
+            if (row)
+            {
+                output.insert(output.end(), row, row + rowSize);
+            }
+            else if (y >= height)
+            {
+                break;
+            }
+        }
+        if (output != reference)
+        {
+            fail("stream", image, settings);
+        }
+    }
+}
+
+// 参数扫描的每个输出与对应参数的参考输出比较，前景数与参考输出中 0 的个数比较
+static void checkSweep(Gray2MonoContext *context, const Bitmap &b, const std::vector<int> &thresholds,
+                       const std::vector<int> &windowSizes, const std::vector<std::vector<unsigned char>> &reference, int threads)
+{
+    const Gray2MonoImage &image = b.image;
+    size_t rowSize = gray2monoRowSize(image.width, 8);
+    size_t combinations = thresholds.size() * windowSizes.size();
+    std::vector<std::vector<unsigned char>> outputs(combinations, std::vector<unsigned char>(rowSize * image.height, 0xCD));
+    std::vector<unsigned char *> dsts;
+    for (auto &output : outputs)
+    {
+        dsts.push_back(output.data());
+    }
+    std::vector<unsigned long long> foreground(combinations);
+
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+    settings.threads = threads;
+    if (gray2monoSweep(context, &image, thresholds.data(), (int)thresholds.size(), windowSizes.data(), (int)windowSizes.size(),
+                       dsts.data(), (int)rowSize, foreground.data(), &settings) != GRAY2MONO_OK)
+    {
+        fail("sweep", image, settings);
+        return;
+    }
+
+    for (size_t i = 0; i < combinations; i++)
+    {
+        settings.threshold = thresholds[i % thresholds.size()];
+        settings.windowSize = windowSizes[i / thresholds.size()];
+
+        unsigned long long black = 0;
+        for (int y = 0; y < image.height; y++)
+        {
+            black += std::count(&reference[i][rowSize * y], &reference[i][rowSize * y + image.width], 0);
+        }
+        if (outputs[i] != reference[i] || foreground[i] != black)
+        {
+            fail("sweep j=" + std::to_string(threads), image, settings);
+        }
+    }
+}
+
+// 分两段累加的直方图与灰度图像 gray 的逐像素计数一致，自动阈值的输出与以 Otsu 阈值运行的输出一致
+static void checkAuto(Gray2MonoContext *context, const Bitmap &b, const Bitmap &gray, int windowSize)
+{
+    const Gray2MonoImage &image = b.image;
+    unsigned long long expected[256] = {0}, histogram[256] = {0};
+    for (int y = 0; y < image.height; y++)
+    {
+        for (int x = 0; x < image.width; x++)
+        {
+            expected[gray.image.data[(size_t)gray.image.stride * y + x]]++;
+        }
+    }
+    int middle = image.height / 2;
+    int error = gray2monoHistogram(context, &image, 0, middle, histogram);
+    if (error == GRAY2MONO_OK)
+    {
+        error = gray2monoHistogram(context, &image, middle, image.height, histogram);
+    }
+
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+    settings.windowSize = windowSize;
+    settings.threads = 2;
+    settings.threshold = GRAY2MONO_THRESHOLD_AUTO;
+    if (error != GRAY2MONO_OK || !std::equal(expected, expected + 256, histogram))
+    {
+        fail("histogram", image, settings);
+        return;
+    }
+
+    // 两个缓冲区的初值不同，任何一次调用失败都不会碰巧相等
+    size_t rowSize = gray2monoRowSize(image.width, 8);
+    std::vector<unsigned char> automatic(rowSize * image.height, 0xCD), fixed(rowSize * image.height, 0xAB);
+    error = gray2monoBinarize(context, &image, automatic.data(), (int)rowSize, &settings);
+    settings.threshold = gray2monoOtsu(histogram);
+    if (error != GRAY2MONO_OK || gray2monoBinarize(context, &image, fixed.data(), (int)rowSize, &settings) != GRAY2MONO_OK ||
+        automatic != fixed)
+    {
+        fail("auto", image, settings);
+    }
+}
+
+// Niblack 与 Sauvola：由灰度图像 gray 逐窗口求和得到的参考输出，与单线程、多线程、1 位输出与原地处理比较
+// 阈值的浮点运算与库中的写法逐项相同，结果逐字节一致
+static void checkLocalStats(Gray2MonoContext *context, const Bitmap &b, const Bitmap &gray, const std::vector<int> &windowSizes)
+{
+    const Gray2MonoImage &image = b.image;
+    int width = image.width, height = image.height;
+    size_t rowSize = gray2monoRowSize(width, 8), packedSize = gray2monoRowSize(width, 1);
+
+    // 像素值与像素平方的积分图
+    size_t satWidth = (size_t)width + 1;
+    std::vector<unsigned long long> sat(satWidth * (height + 1), 0), sqSat(satWidth * (height + 1), 0);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *row = gray.image.data + (size_t)gray.image.stride * y;
+        for (int x = 0; x < width; x++)
+        {
+            size_t i = satWidth * (y + 1) + x + 1;
+            sat[i] = sat[i - 1] + sat[i - satWidth] - sat[i - satWidth - 1] + row[x];
+            sqSat[i] = sqSat[i - 1] + sqSat[i - satWidth] - sqSat[i - satWidth - 1] + (unsigned int)row[x] * row[x];
+        }
+    }
+
+    const struct
+    {
+        const char *name;
+        int method;
+        double k;
+        double r;
+    } methods[] = {{"niblack", GRAY2MONO_METHOD_NIBLACK, -0.2, 128}, {"niblack", GRAY2MONO_METHOD_NIBLACK, 0.5, 128},
+                   {"sauvola", GRAY2MONO_METHOD_SAUVOLA, 0.5, 128}, {"sauvola", GRAY2MONO_METHOD_SAUVOLA, 0.2, 64}};
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+    std::vector<unsigned char> reference(rowSize * height), output;
+    for (int windowSize : windowSizes)
+    {
+        int half = windowSize / 2;
+        for (auto &method : methods)
+        {
+            for (int y = 0; y < height; y++)
+            {
+                int y1 = std::max(y - half, 0), y2 = std::min(y + half + 1, height);
+                const unsigned char *row = gray.image.data + (size_t)gray.image.stride * y;
+                for (int x = 0; x < width; x++)
+                {
+                    int x1 = std::max(x - half, 0), x2 = std::min(x + half + 1, width);
+                    double count = (double)(x2 - x1) * (y2 - y1);
+                    double sum = (double)(sat[satWidth * y2 + x2] - sat[satWidth * y2 + x1] - sat[satWidth * y1 + x2] + sat[satWidth * y1 + x1]);
+                    double sqSum = (double)(sqSat[satWidth * y2 + x2] - sqSat[satWidth * y2 + x1] - sqSat[satWidth * y1 + x2] +
+                                            sqSat[satWidth * y1 + x1]);
+                    double mean = sum / count;
+                    double variance = sqSum / count - mean * mean;
+                    double deviation = variance > 0 ? std::sqrt(variance) : 0;
+                    double threshold = method.method == GRAY2MONO_METHOD_NIBLACK ? mean + method.k * deviation
+                                                                                 : mean * (1 + method.k * (deviation / method.r - 1));
+                    reference[rowSize * y + x] = row[x] > threshold ? 255 : 0;
+                }
+                std::fill(&reference[rowSize * y + width], &reference[rowSize * (y + 1)], 0);
+            }
+
+            settings.method = method.method;
+            settings.k = method.k;
+            settings.r = method.r;
+            settings.windowSize = windowSize;
+            settings.bitCount = 8;
+            for (int threads : {1, 3})
+            {
+                settings.threads = threads;
+                output.assign(rowSize * height, 0xCD);
+                if (gray2monoBinarize(context, &image, output.data(), (int)rowSize, &settings) != GRAY2MONO_OK || output != reference)
+                {
+                    fail(std::string(method.name) + " j=" + std::to_string(threads), image, settings);
+                }
+            }
+
+            settings.bitCount = 1;
+            output.assign(packedSize * height, 0xCD);
+            if (gray2monoBinarize(context, &image, output.data(), (int)packedSize, &settings) != GRAY2MONO_OK ||
+                output != packReference(reference, width, height))
+            {
+                fail(std::string(method.name) + " j=3 1-bit", image, settings);
+            }
+
+            settings.threads = 1;
+            settings.bitCount = 8;
+            std::vector<unsigned char> inPlace(b.file.begin() + b.bmp.pixelOffset, b.file.end());
+            Gray2MonoImage inPlaceImage = image;
+            inPlaceImage.data = inPlace.data();
+            if (gray2monoBinarize(context, &inPlaceImage, inPlace.data(), (int)rowSize, &settings) != GRAY2MONO_OK ||
+                !std::equal(reference.begin(), reference.end(), inPlace.begin()))
+            {
+                fail(std::string(method.name) + " in-place", image, settings);
+            }
+        }
+    }
+}
+
+// 行距为 0 或负数时所有入口都返回 GRAY2MONO_ERROR_SETTINGS，不读写任何像素
+static void checkStrides(Gray2MonoContext *context, std::mt19937 &gen)
+{
+    Bitmap b = makeBitmap(13, 9, NOISE, gen);
+    size_t rowSize = gray2monoRowSize(13, 8);
+    std::vector<unsigned char> output(rowSize * 9);
+    unsigned char *dst = output.data();
+    unsigned long long histogram[256] = {0}, foreground = 0;
+    int threshold = 128, windowSize = 3;
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+
+    for (int stride : {0, -(int)b.image.stride})
+    {
+        Gray2MonoImage image = b.image;
+        image.stride = stride;
+        if (gray2monoBinarize(context, &image, dst, (int)rowSize, &settings) != GRAY2MONO_ERROR_SETTINGS ||
+            gray2monoHistogram(context, &image, 0, image.height, histogram) != GRAY2MONO_ERROR_SETTINGS ||
+            gray2monoSweep(context, &image, &threshold, 1, &windowSize, 1, &dst, (int)rowSize, &foreground, &settings) != GRAY2MONO_ERROR_SETTINGS ||
+            gray2monoStreamBegin(context, &image, &settings) != GRAY2MONO_ERROR_SETTINGS)
+        {
+            fail("stride " + std::to_string(stride), image, settings);
+        }
+        if (gray2monoBinarize(context, &b.image, dst, stride, &settings) != GRAY2MONO_ERROR_SETTINGS ||
+            gray2monoSweep(context, &b.image, &threshold, 1, &windowSize, 1, &dst, stride, &foreground, &settings) != GRAY2MONO_ERROR_SETTINGS)
+        {
+            fail("dstStride " + std::to_string(stride), b.image, settings);
+        }
+    }
+}
+
+// 小窗口、2 的幂减 1 与不超过图像宽高的最大几个奇数窗口
+static std::vector<int> windowSizesFor(int width, int height)
+{
+    int limit = std::min(width, height);
+    int largest = limit % 2 ? limit : limit - 1;
+    std::vector<int> sizes;
+    for (int r : {1, 3, 5, 7, 9, 15, 31, 63, 127, largest - 2, largest})
+    {
+        if (r >= 1 && r <= largest && std::find(sizes.begin(), sizes.end(), r) == sizes.end())
+        {
+            sizes.push_back(r);
+        }
+    }
+    return sizes;
+}
+
+static void checkAll(Gray2MonoContext *context, std::mt19937 &gen)
+{
+    std::vector<std::pair<int, int>> sizes = {{1, 1}, {1, 7}, {7, 1}, {2, 3}, {3, 2}, {5, 5}, {13, 9}, {31, 17}, {33, 64},
+                                              {64, 33}, {101, 77}, {250, 3}, {3, 250}, {151, 97}};
+    std::uniform_int_distribution<int> sizeDis(1, 96);
+    for (int i = 0; i < 16; i++)
+    {
+        sizes.push_back({sizeDis(gen), sizeDis(gen)});
+    }
+
+    std::uniform_int_distribution<int> thresholdDis(0, 255);
+    const int colorDepths[] = {24, 32, 8};
+    int cases = 0, colorCases = 0;
+    for (auto &size : sizes)
+    {
+        for (int pattern = 0; pattern < PATTERN_COUNT; pattern++)
+        {
+            Bitmap b = makeBitmap(size.first, size.second, (Pattern)pattern, gen);
+            std::vector<int> windowSizes = windowSizesFor(size.first, size.second);
+            std::vector<int> thresholds = {0, 127, 128, 255, thresholdDis(gen)};
+            if (pattern == CONSTANT)
+            {
+                // 常数图像的均值恰好等于像素值，阈值取在它的两侧
+                int level = b.image.data[0];
+                thresholds = {std::max(level - 1, 0), level, std::min(level + 1, 255)};
+            }
+
+            std::vector<std::vector<unsigned char>> reference = references(context, b, thresholds, windowSizes);
+            Gray2MonoSettings settings;
+            gray2monoDefaultSettings(&settings);
+            for (size_t i = 0; i < reference.size(); i++)
+            {
+                settings.windowSize = windowSizes[i / thresholds.size()];
+                settings.threshold = thresholds[i % thresholds.size()];
+                checkPaths(context, b, settings, reference[i]);
+                cases++;
+            }
+            checkSweep(context, b, thresholds, windowSizes, reference, 1);
+            checkSweep(context, b, thresholds, windowSizes, reference, 4);
+            checkAuto(context, b, b, windowSizes.back());
+            checkLocalStats(context, b, b, windowSizes);
+
+            // 亮度相同的 24 位、32 位与调色板输入轮流各取一种，经过颜色转换后应得到同样的参考输出
+            Bitmap color = recolor(b, colorDepths[colorCases++ % 3], gen);
+            for (size_t i = 0; i < reference.size(); i++)
+            {
+                settings.windowSize = windowSizes[i / thresholds.size()];
+                settings.threshold = thresholds[i % thresholds.size()];
+                checkPaths(context, color, settings, reference[i]);
+                cases++;
+            }
+            checkSweep(context, color, thresholds, windowSizes, reference, 4);
+            checkAuto(context, color, b, windowSizes.back());
+            checkLocalStats(context, color, b, windowSizes);
+        }
+    }
+    std::cout << cases << " cases checked." << std::endl;
+}
+
+// 防止编译器优化掉结果
+static volatile unsigned char sink;
+
+// 重复执行直到耗时足够长，返回每秒处理的百万像素数
+template <typename F>
+static double measure(const std::string &label, double megapixels, F &&f)
+{
+    AutoTimer timer(label, "std", "[{time}] ({label}) <{commitID-s}> {duration} seconds.", "none", 6);
+    int repeat = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    while (repeat < 3 || seconds < 0.5)
+    {
+        f();
+        repeat++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return megapixels * repeat / seconds;
+}
+
+static void report(const std::string &path, int threads, double megapixelsPerSecond)
+{
+    std::cout << std::left << std::setw(24) << path << std::setw(8) << threads
+              << std::right << std::fixed << std::setprecision(1) << std::setw(10) << megapixelsPerSecond << " MP/s" << std::endl;
+}
+
+static void benchmark(Gray2MonoContext *context, int width, std::mt19937 &gen)
+{
+    int height = width * 3 / 4;
+    Bitmap b = makeBitmap(width, height, GRADIENT, gen);
+    double megapixels = (double)width * height / 1e6;
+    size_t rowSize = gray2monoRowSize(width, 8);
+    std::vector<unsigned char> output(rowSize * height);
+
+    std::cout << "\n" << width << "x" << height << std::endl;
+    std::cout << std::left << std::setw(24) << "path" << std::setw(8) << "threads" << std::endl;
+
+    int hardware = gray2monoHardwareConcurrency();
+    std::vector<int> threadCounts = {1};
+    for (int threads = 2; threads < hardware; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    if (hardware > 1)
+    {
+        threadCounts.push_back(hardware);
+    }
+
+    const struct
+    {
+        const char *name;
+        int algorithm;
+    } engines[] = {{"naive", GRAY2MONO_ALGORITHM_NAIVE}, {"integral", GRAY2MONO_ALGORITHM_INTEGRAL}, {"box", GRAY2MONO_ALGORITHM_BOX},
+                   {"tiled", GRAY2MONO_ALGORITHM_TILED}};
+
+    Gray2MonoSettings settings;
+    gray2monoDefaultSettings(&settings);
+    for (int windowSize : {3, 15, 61})
+    {
+        settings.windowSize = windowSize;
+        for (auto &engine : engines)
+        {
+            // 朴素实现为 O(r^2)，大窗口耗时过长
+            if (engine.algorithm == GRAY2MONO_ALGORITHM_NAIVE && windowSize > 3)
+            {
+                continue;
+            }
+            settings.algorithm = engine.algorithm;
+            for (int threads : threadCounts)
+            {
+                settings.threads = threads;
+                std::string path = std::string(engine.name) + " r=" + std::to_string(windowSize);
+                report(path, threads, measure(path + " j=" + std::to_string(threads), megapixels, [&]
+                                              {
+                                                  gray2monoBinarize(context, &b.image, output.data(), (int)rowSize, &settings);
+                                                  sink = output[0]; }));
+            }
+        }
+
+        settings.algorithm = GRAY2MONO_ALGORITHM_BOX;
+        settings.threads = 1;
+        std::string path = "stream r=" + std::to_string(windowSize);
+        report(path, 1, measure(path, megapixels, [&]
+                                {
+                                    gray2monoStreamBegin(context, &b.image, &settings);
+                                    for (int y = 0; y <= height; y++)
+                                    {
+                                        const unsigned char *row = gray2monoStreamRow(context, y < height ? b.image.data + (size_t)b.image.stride * y : nullptr);
+                                        while (y == height && row)
+                                        {
+                                            row = gray2monoStreamRow(context, nullptr);
+                                        }
+                                    }
+                                    sink = 0; }));
+    }
+
+    // 参数扫描按输出的组合数计算吞吐率
+    std::vector<int> thresholds = {96, 128, 160, 192};
+    std::vector<int> windowSizes = {3, 15, 61};
+    size_t combinations = thresholds.size() * windowSizes.size();
+    std::vector<unsigned char> outputs(rowSize * height * combinations);
+    std::vector<unsigned char *> dsts;
+    for (size_t i = 0; i < combinations; i++)
+    {
+        dsts.push_back(&outputs[rowSize * height * i]);
+    }
+    for (int threads : threadCounts)
+    {
+        settings.threads = threads;
+        std::string path = "sweep 4x3";
+        report(path, threads, measure(path + " j=" + std::to_string(threads), megapixels * combinations, [&]
+                                      {
+                                          gray2monoSweep(context, &b.image, thresholds.data(), (int)thresholds.size(),
+                                                         windowSizes.data(), (int)windowSizes.size(), dsts.data(), (int)rowSize, nullptr, &settings);
+                                          sink = outputs[0]; }));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int benchmarkWidth = argc > 1 ? std::atoi(argv[1]) : 4096;
+    std::mt19937 gen(argc > 2 ? std::atoi(argv[2]) : 12345);
+
+    Gray2MonoContext *context = gray2monoCreate();
+    if (!context)
+    {
+        std::cerr << "Failed to create context." << std::endl;
+        return 1;
+    }
+
+    // 先试运行选出块大小，比对时换成最小的块，让块的接缝与光晕落在小图内部
+    int tileWidth, tileHeight;
+    gray2monoTileSize(context, &tileWidth, &tileHeight);
+    std::cout << "Tuned tile size: " << tileWidth << "x" << tileHeight << std::endl;
+    gray2monoSetTileSize(16, 1);
+
+    checkAll(context, gen);
+    checkStrides(context, gen);
+    if (failures)
+    {
+        std::cerr << failures << " mismatches." << std::endl;
+        gray2monoDestroy(context);
+        return 1;
+    }
+    std::cout << "All paths matched the naive reference." << std::endl;
+
+    if (benchmarkWidth > 0)
+    {
+        gray2monoSetTileSize(tileWidth, tileHeight);
+        benchmark(context, benchmarkWidth, gen);
+    }
+
+    gray2monoDestroy(context);
+    return 0;
+}
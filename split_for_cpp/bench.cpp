@@ -0,0 +1,240 @@
+/**
+ * Benchmark for hazuki::split.
+ *
+ *      g++ -std=c++20 -O2 bench.cpp -o bench
+ *      ./bench [max size in bytes, default 64M, e.g. 1G]
+ *
+ * Every case is a generated string of tokens with a fixed length, joined by a
+ * delimiter. Sizes grow by 8x from 64B up to the given maximum. Each container
+ * supported by split() is measured, together with std::getline, strtok_r and
+ * std::views::split as baselines. Results are reported in GB/s and Mtokens/s.
+ *
+ * Paths that keep every token (owning containers, string_view vectors, id
+ * lists and the baselines, which collect std::strings) are skipped once their
+ * estimated output exceeds 1 GiB, so ./bench 1G fits in about 4 GB of RAM.
+ * At the largest sizes that leaves the deduplicating containers plus the
+ * view and id paths where the tokens are long enough.
+ */
+
+#include "split.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define strtok_r strtok_s
+#endif
+
+// 防止编译器优化掉结果
+static volatile size_t sink;
+
+struct Case
+{
+    size_t tokenLength;
+    std::string delimiter;
+    size_t size;
+    std::string text;
+    size_t tokenCount;
+};
+
+// 生成由若干重复 token 组成的输入
+static Case makeCase(size_t tokenLength, const std::string &delimiter, size_t size)
+{
+    Case c{tokenLength, delimiter, size, {}, 0};
+    std::mt19937 gen(42);
+    // 取值范围较小，保证去重容器中存在大量重复
+    std::uniform_int_distribution<int> dis(0, 1023);
+
+    c.text.reserve(size + tokenLength + delimiter.size());
+    while (c.text.size() < size)
+    {
+        std::string token = std::to_string(dis(gen));
+        token.resize(tokenLength, 'x');
+        c.text += token;
+        c.text += delimiter;
+        c.tokenCount++;
+    }
+    c.text.resize(size);
+    return c;
+}
+
+// 重复执行直到耗时足够长，返回每次的平均秒数
+template <typename F>
+static double measure(F &&f, size_t size)
+{
+    size_t repeat = std::max<size_t>(1, (64u << 20) / std::max<size_t>(size, 1));
+    double best = 1e30;
+    for (int round = 0; round < 3; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeat; i++)
+        {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count() / repeat);
+    }
+    return best;
+}
+
+static void report(const Case &c, const char *name, double seconds)
+{
+    std::cout << std::left << std::setw(10) << c.size
+              << std::setw(6) << c.tokenLength
+              << std::setw(6) << ("\"" + c.delimiter + "\"")
+              << std::setw(28) << name
+              << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << c.size / seconds / 1e9 << " GB/s"
+              << std::setw(12) << c.tokenCount / seconds / 1e6 << " Mtok/s" << std::endl;
+}
+
+// 保存全部 token 的输出超过这个估计大小时跳过该路径
+static const size_t memoryBudget = size_t(1) << 30;
+
+static void skip(const Case &c, const char *name)
+{
+    std::cout << std::left << std::setw(10) << c.size
+              << std::setw(6) << c.tokenLength
+              << std::setw(6) << ("\"" + c.delimiter + "\"")
+              << std::setw(28) << name << "skipped (output > 1 GiB)" << std::endl;
+}
+
+static void runCase(const Case &c)
+{
+    const std::string &text = c.text;
+    const std::string &delimiter = c.delimiter;
+
+    // 每个 token 的估计开销：std::string 本身，超出短字符串缓冲（libstdc++ 与 MSVC 为 15 字节）时另加堆分配
+    size_t owned = c.tokenCount * (sizeof(std::string) + (c.tokenLength > 15 ? c.tokenLength + 1 : 0));
+    size_t views = c.tokenCount * sizeof(std::string_view);
+    size_t ids = c.tokenCount * sizeof(std::uint32_t);
+    auto run = [&](const char *name, size_t bytes, auto &&f)
+    {
+        if (bytes > memoryBudget)
+        {
+            skip(c, name);
+            return;
+        }
+        report(c, name, measure(f, c.size));
+    };
+
+    // 去重容器与 pair 只保存少量 token，任何尺寸都运行
+    run("vector<string>", owned, [&]
+        { sink = hazuki::split<std::vector<std::string>>(text, delimiter).size(); });
+    run("vector<string_view>", views, [&]
+        { sink = hazuki::split<std::vector<std::string_view>>(text, delimiter).size(); });
+    run("set<string>", 0, [&]
+        { sink = hazuki::split<std::set<std::string>>(text, delimiter).size(); });
+    run("stack<string>", owned, [&]
+        { sink = hazuki::split<std::stack<std::string>>(text, delimiter).size(); });
+    run("queue<string>", owned, [&]
+        { sink = hazuki::split<std::queue<std::string>>(text, delimiter).size(); });
+    run("pair<string, string>", 0, [&]
+        { sink = hazuki::split<std::pair<std::string, std::string>>(text, delimiter).second.size(); });
+    run("flat_hash_set (view)", 0, [&]
+        { sink = hazuki::split<hazuki::flat_hash_set>(text, delimiter).size(); });
+    // flat_set 先收集全部 token 再排序
+    run("flat_set (view)", views, [&]
+        { sink = hazuki::split<hazuki::flat_set>(text, delimiter).size(); });
+    run("interner (ids)", ids, [&]
+        {
+            hazuki::interner pool;
+            sink = hazuki::split(text, delimiter, pool).size(); });
+
+    // 同一个 interner 反复切分相似的行，模拟稳态
+    hazuki::interner warm;
+    if (ids <= memoryBudget)
+    {
+        hazuki::split(text, delimiter, warm);
+    }
+    run("interner (warm)", ids, [&]
+        { sink = hazuki::split(text, delimiter, warm).size(); });
+
+    // 以下为基准实现，只支持单字符分隔符
+    if (delimiter.size() == 1)
+    {
+        run("std::getline", owned, [&]
+            {
+                std::istringstream in(text);
+                std::vector<std::string> tokens;
+                std::string token;
+                while (std::getline(in, token, delimiter[0]))
+                {
+                    tokens.push_back(token);
+                }
+                sink = tokens.size(); });
+
+        std::vector<char> buffer(text.size() + 1);
+        run("strtok_r", owned, [&]
+            {
+                std::memcpy(buffer.data(), text.c_str(), text.size() + 1);
+                std::vector<std::string> tokens;
+                char *save = nullptr;
+                for (char *p = strtok_r(buffer.data(), delimiter.c_str(), &save); p; p = strtok_r(nullptr, delimiter.c_str(), &save))
+                {
+                    tokens.emplace_back(p);
+                }
+                sink = tokens.size(); });
+    }
+
+    run("views::split", owned, [&]
+        {
+            std::vector<std::string> tokens;
+            for (auto &&part : std::views::split(std::string_view(text), std::string_view(delimiter)))
+            {
+                tokens.emplace_back(part.begin(), part.end());
+            }
+            sink = tokens.size(); });
+}
+
+static size_t parseSize(const char *arg)
+{
+    char *end = nullptr;
+    size_t value = std::strtoull(arg, &end, 10);
+    switch (*end)
+    {
+    case 'G': case 'g': value <<= 30; break;
+    case 'M': case 'm': value <<= 20; break;
+    case 'K': case 'k': value <<= 10; break;
+    default: break;
+    }
+    return value;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxSize = argc > 1 ? parseSize(argv[1]) : (64u << 20);
+
+    std::cout << std::left << std::setw(10) << "bytes" << std::setw(6) << "tok"
+              << std::setw(6) << "delim" << std::setw(28) << "path" << std::endl;
+
+    // 从 64B 开始按 8 倍增长，最后补上最大尺寸
+    std::vector<size_t> sizes;
+    for (size_t size = 64; size < maxSize; size *= 8)
+    {
+        sizes.push_back(size);
+    }
+    sizes.push_back(maxSize);
+
+    for (size_t size : sizes)
+    {
+        for (size_t tokenLength : {1, 8, 64})
+        {
+            for (const char *delimiter : {",", "::"})
+            {
+                runCase(makeCase(tokenLength, delimiter, size));
+            }
+        }
+    }
+
+    return 0;
+}
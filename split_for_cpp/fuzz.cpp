@@ -0,0 +1,216 @@
+/**
+ * Differential fuzzer for hazuki::split.
+ *
+ *      g++ -std=c++17 -O2 fuzz.cpp -o fuzz
+ *      ./fuzz [iterations, default 100000] [seed]
+ *
+ * Every container and the interner overload are compared against a plain
+ * character-by-character reference tokenizer. Inputs are drawn from a small
+ * alphabet that overlaps the delimiter, so leading, trailing and consecutive
+ * delimiters as well as partial delimiter matches show up constantly.
+ * A second, smaller pass mixes short tokens with tokens at and beyond the
+ * interner's 64 KiB block size, so oversized blocks are followed by more
+ * interning into the same pool.
+ */
+
+#include "split.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 参考实现：逐字符匹配，保留中间和开头的空 token，丢弃末尾的空 token
+static std::vector<std::string> reference(const std::string &str, const std::string &delimiter)
+{
+    std::vector<std::string> tokens;
+    std::string current;
+    size_t i = 0;
+    while (i < str.size())
+    {
+        if (str.compare(i, delimiter.size(), delimiter) == 0)
+        {
+            tokens.push_back(current);
+            current.clear();
+            i += delimiter.size();
+        }
+        else
+        {
+            current += str[i++];
+        }
+    }
+    if (!current.empty())
+    {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+static int failures = 0;
+
+static void fail(const std::string &what, const std::string &str, const std::string &delimiter)
+{
+    if (failures++ < 10)
+    {
+        // 长输入只打印开头与长度
+        std::string shown = str.size() > 80 ? str.substr(0, 80) + "...(" + std::to_string(str.size()) + " chars)" : str;
+        std::cerr << "Mismatch in " << what << ": str=\"" << shown << "\" delimiter=\"" << delimiter << "\"" << std::endl;
+    }
+}
+
+static void check(const std::string &str, const std::string &delimiter)
+{
+    std::vector<std::string> expected = reference(str, delimiter);
+    std::set<std::string> expectedSet(expected.begin(), expected.end());
+
+    if (hazuki::split<std::vector<std::string>>(str, delimiter) != expected)
+    {
+        fail("vector", str, delimiter);
+    }
+
+    std::vector<std::string_view> views = hazuki::split<std::vector<std::string_view>>(str, delimiter);
+    if (std::vector<std::string>(views.begin(), views.end()) != expected)
+    {
+        fail("vector<string_view>", str, delimiter);
+    }
+
+    if (hazuki::split<std::set<std::string>>(str, delimiter) != expectedSet)
+    {
+        fail("set", str, delimiter);
+    }
+
+    std::stack<std::string> stack = hazuki::split<std::stack<std::string>>(str, delimiter);
+    std::queue<std::string> queue = hazuki::split<std::queue<std::string>>(str, delimiter);
+    bool stackOk = stack.size() == expected.size();
+    bool queueOk = queue.size() == expected.size();
+    for (size_t i = 0; stackOk && i < expected.size(); i++)
+    {
+        stackOk = stack.top() == expected[expected.size() - 1 - i];
+        stack.pop();
+    }
+    for (size_t i = 0; queueOk && i < expected.size(); i++)
+    {
+        queueOk = queue.front() == expected[i];
+        queue.pop();
+    }
+    if (!stackOk)
+    {
+        fail("stack", str, delimiter);
+    }
+    if (!queueOk)
+    {
+        fail("queue", str, delimiter);
+    }
+
+    // pair 只在第一个分隔符处切分
+    std::pair<std::string, std::string> pair = hazuki::split<std::pair<std::string, std::string>>(str, delimiter);
+    size_t pos = str.find(delimiter);
+    std::pair<std::string, std::string> expectedPair = pos == std::string::npos
+                                                           ? std::make_pair(str, std::string())
+                                                           : std::make_pair(str.substr(0, pos), str.substr(pos + delimiter.size()));
+    if (pair != expectedPair)
+    {
+        fail("pair", str, delimiter);
+    }
+
+    // flat_hash_set 按首次出现的顺序保存
+    hazuki::flat_hash_set hashSet = hazuki::split<hazuki::flat_hash_set>(str, delimiter);
+    std::vector<std::string> firstSeen;
+    std::set<std::string> seen;
+    for (auto &token : expected)
+    {
+        if (seen.insert(token).second)
+        {
+            firstSeen.push_back(token);
+        }
+    }
+    if (std::vector<std::string>(hashSet.begin(), hashSet.end()) != firstSeen)
+    {
+        fail("flat_hash_set", str, delimiter);
+    }
+
+    hazuki::flat_set flatSet = hazuki::split<hazuki::flat_set>(str, delimiter);
+    if (std::vector<std::string>(flatSet.begin(), flatSet.end()) != std::vector<std::string>(expectedSet.begin(), expectedSet.end()))
+    {
+        fail("flat_set", str, delimiter);
+    }
+
+    // 同一个 interner 切分两次，id 必须一致
+    hazuki::interner pool;
+    std::vector<std::uint32_t> ids = hazuki::split(str, delimiter, pool);
+    bool internOk = ids.size() == expected.size() && pool.size() == expectedSet.size() &&
+                    hazuki::split(str, delimiter, pool) == ids;
+    for (size_t i = 0; internOk && i < ids.size(); i++)
+    {
+        internOk = pool.str(ids[i]) == expected[i];
+    }
+    if (!internOk)
+    {
+        fail("interner", str, delimiter);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? std::atol(argv[1]) : 100000;
+    std::mt19937 gen(argc > 2 ? std::atoi(argv[2]) : 12345);
+
+    // 边界情况
+    const char *edgeCases[] = {"", ",", ",,", "a", "a,", ",a", ",a,", "a,,b", ",,a,,", "a,b,c", "aa,,bb,"};
+    for (const char *str : edgeCases)
+    {
+        check(str, ",");
+    }
+    check("a::b:c:::d::", "::");
+    check("ababab", "ab");
+    check("aaa", "aa");
+
+    const std::string alphabet = "ab,:;";
+    std::uniform_int_distribution<int> charDis(0, alphabet.size() - 1);
+    std::uniform_int_distribution<int> lengthDis(0, 40);
+    std::uniform_int_distribution<int> delimiterDis(1, 3);
+
+    for (long i = 0; i < iterations; i++)
+    {
+        std::string str, delimiter;
+        for (int n = lengthDis(gen); n > 0; n--)
+        {
+            str += alphabet[charDis(gen)];
+        }
+        for (int n = delimiterDis(gen); n > 0; n--)
+        {
+            delimiter += alphabet[charDis(gen)];
+        }
+        check(str, delimiter);
+    }
+
+    // 长 token：长度取在 interner 块大小 64 KiB 的两侧，前后穿插短 token
+    const size_t blockSize = 64 * 1024;
+    const size_t longLengths[] = {blockSize - 1, blockSize, blockSize + 1, blockSize * 3};
+    std::uniform_int_distribution<int> pickDis(0, 5);
+    std::uniform_int_distribution<size_t> longDis(blockSize / 2, blockSize * 2);
+    std::uniform_int_distribution<int> countDis(1, 6);
+    long longIterations = iterations / 1000 + 20;
+    for (long i = 0; i < longIterations; i++)
+    {
+        std::string str;
+        for (int tokens = countDis(gen); tokens > 0; tokens--)
+        {
+            int pick = pickDis(gen);
+            size_t length = pick < 4 ? longLengths[pick] : pick == 4 ? longDis(gen) : (size_t)lengthDis(gen) % 8;
+            char c = "xyz"[pick % 3];
+            str += std::string(length, c);
+            str += ',';
+        }
+        str += "abc";
+        check(str, ",");
+    }
+
+    if (failures)
+    {
+        std::cerr << failures << " mismatches." << std::endl;
+        return 1;
+    }
+    std::cout << "All " << iterations << " cases matched." << std::endl;
+    return 0;
+}
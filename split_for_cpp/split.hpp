@@ -3,10 +3,17 @@
  *
  * @tparam Container The type of container to store the result.
  *                  Supported types: std::set<std::string>, std::vector<std::string>,
- *                  std::stack<std::string>, std::queue<std::string>, std::pair<std::string, std::string>.
+ *                  std::stack<std::string>, std::queue<std::string>, std::pair<std::string, std::string>,
+ *                  std::vector<std::string_view>, hazuki::flat_hash_set, hazuki::flat_set.
  * @param str The input string to be split.
  * @param delimiter The delimiter used to split the string.
  * @return Container A container holding the split results.
+ *
+ * std::vector<std::string_view>, hazuki::flat_hash_set and hazuki::flat_set hold
+ * std::string_view tokens that point into str, so str must outlive the returned container.
+ *
+ * split(str, delimiter, interner) returns the ids of the tokens in a hazuki::interner,
+ * which keeps its own copy of every distinct token.
  */
 
 #ifndef HAZUKI_SPLIT_HPP
@@ -20,9 +27,254 @@
 #include <queue>
 #include <utility>
 #include <type_traits>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstring>
 
 namespace hazuki
 {
+    /**
+     * @brief Open-addressing hash set of std::string_view.
+     *
+     * Keys are kept densely in insertion order, the probe table only stores
+     * indices into that array, so lookups touch one cache line per probe and
+     * no node is allocated per token. The index of a key is stable and can
+     * be used as an id.
+     */
+    class flat_hash_set
+    {
+    public:
+        using value_type = std::string_view;
+        using const_iterator = std::vector<std::string_view>::const_iterator;
+        static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+        flat_hash_set() = default;
+
+        // Returns the index of key and whether it was newly inserted.
+        std::pair<std::uint32_t, bool> insert(std::string_view key)
+        {
+            if ((keys_.size() + 1) * 4 > slots_.size() * 3)
+            {
+                rehash(slots_.empty() ? 16 : slots_.size() * 2);
+            }
+
+            std::size_t hash = std::hash<std::string_view>{}(key);
+            std::size_t mask = slots_.size() - 1;
+            for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+            {
+                std::uint32_t slot = slots_[i];
+                if (slot == 0)
+                {
+                    slots_[i] = static_cast<std::uint32_t>(keys_.size()) + 1;
+                    keys_.push_back(key);
+                    hashes_.push_back(hash);
+                    return {static_cast<std::uint32_t>(keys_.size() - 1), true};
+                }
+                if (hashes_[slot - 1] == hash && keys_[slot - 1] == key)
+                {
+                    return {slot - 1, false};
+                }
+            }
+        }
+
+        // Returns the index of key, or npos if it is not in the set.
+        std::uint32_t find(std::string_view key) const
+        {
+            if (slots_.empty())
+            {
+                return npos;
+            }
+
+            std::size_t hash = std::hash<std::string_view>{}(key);
+            std::size_t mask = slots_.size() - 1;
+            for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+            {
+                std::uint32_t slot = slots_[i];
+                if (slot == 0)
+                {
+                    return npos;
+                }
+                if (hashes_[slot - 1] == hash && keys_[slot - 1] == key)
+                {
+                    return slot - 1;
+                }
+            }
+        }
+
+        bool contains(std::string_view key) const { return find(key) != npos; }
+
+        void reserve(std::size_t count)
+        {
+            keys_.reserve(count);
+            hashes_.reserve(count);
+            std::size_t capacity = 16;
+            while (capacity * 3 < count * 4)
+            {
+                capacity *= 2;
+            }
+            if (capacity > slots_.size())
+            {
+                rehash(capacity);
+            }
+        }
+
+        void clear()
+        {
+            keys_.clear();
+            hashes_.clear();
+            std::fill(slots_.begin(), slots_.end(), 0);
+        }
+
+        std::string_view operator[](std::uint32_t index) const { return keys_[index]; }
+        std::size_t size() const { return keys_.size(); }
+        bool empty() const { return keys_.empty(); }
+        const_iterator begin() const { return keys_.begin(); }
+        const_iterator end() const { return keys_.end(); }
+
+    private:
+        void rehash(std::size_t capacity)
+        {
+            slots_.assign(capacity, 0);
+            std::size_t mask = capacity - 1;
+            for (std::size_t k = 0; k < keys_.size(); k++)
+            {
+                std::size_t i = hashes_[k] & mask;
+                while (slots_[i] != 0)
+                {
+                    i = (i + 1) & mask;
+                }
+                slots_[i] = static_cast<std::uint32_t>(k) + 1;
+            }
+        }
+
+        std::vector<std::string_view> keys_;
+        std::vector<std::size_t> hashes_;
+        std::vector<std::uint32_t> slots_;
+    };
+
+    /**
+     * @brief Sorted, duplicate-free vector of std::string_view.
+     *
+     * Same ordering as std::set<std::string>, but stored contiguously. Bulk
+     * insertion appends, sorts and removes duplicates once instead of
+     * rebalancing a tree per element.
+     */
+    class flat_set
+    {
+    public:
+        using value_type = std::string_view;
+        using const_iterator = std::vector<std::string_view>::const_iterator;
+
+        flat_set() = default;
+
+        bool insert(std::string_view key)
+        {
+            auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+            if (it != keys_.end() && *it == key)
+            {
+                return false;
+            }
+            keys_.insert(it, key);
+            return true;
+        }
+
+        template <typename InputIt>
+        void insert(InputIt first, InputIt last)
+        {
+            std::size_t sorted = keys_.size();
+            keys_.insert(keys_.end(), first, last);
+            std::sort(keys_.begin() + sorted, keys_.end());
+            std::inplace_merge(keys_.begin(), keys_.begin() + sorted, keys_.end());
+            keys_.erase(std::unique(keys_.begin(), keys_.end()), keys_.end());
+        }
+
+        bool contains(std::string_view key) const
+        {
+            return std::binary_search(keys_.begin(), keys_.end(), key);
+        }
+
+        void clear() { keys_.clear(); }
+
+        std::string_view operator[](std::size_t index) const { return keys_[index]; }
+        std::size_t size() const { return keys_.size(); }
+        bool empty() const { return keys_.empty(); }
+        const_iterator begin() const { return keys_.begin(); }
+        const_iterator end() const { return keys_.end(); }
+
+    private:
+        std::vector<std::string_view> keys_;
+    };
+
+    /**
+     * @brief Maps tokens to stable integer ids.
+     *
+     * Every distinct token is copied once into an arena of fixed-size blocks,
+     * so views returned by str() stay valid for the lifetime of the interner
+     * and repeated tokens in later splits cost a hash lookup, not an allocation.
+     */
+    class interner
+    {
+    public:
+        interner() = default;
+        interner(const interner &) = delete;
+        interner &operator=(const interner &) = delete;
+
+        std::uint32_t intern(std::string_view token)
+        {
+            std::uint32_t id = ids_.find(token);
+            if (id != flat_hash_set::npos)
+            {
+                return id;
+            }
+            return ids_.insert(store(token)).first;
+        }
+
+        // Returns the id of token, or flat_hash_set::npos if it was never interned.
+        std::uint32_t find(std::string_view token) const { return ids_.find(token); }
+
+        std::string_view str(std::uint32_t id) const { return ids_[id]; }
+        std::size_t size() const { return ids_.size(); }
+
+    private:
+        static constexpr std::size_t blockSize = 64 * 1024;
+
+        std::string_view store(std::string_view token)
+        {
+            if (token.empty())
+            {
+                return std::string_view();
+            }
+            if (blocks_.empty())
+            {
+                blocks_.emplace_back(new char[blockSize]);
+                used_ = 0;
+            }
+            if (token.size() > blockSize)
+            {
+                // Oversized tokens get a block of their own, inserted in front of
+                // the current block so that it keeps filling from used_.
+                char *dst = blocks_.emplace(blocks_.end() - 1, new char[token.size()])->get();
+                std::memcpy(dst, token.data(), token.size());
+                return std::string_view(dst, token.size());
+            }
+            if (token.size() > blockSize - used_)
+            {
+                blocks_.emplace_back(new char[blockSize]);
+                used_ = 0;
+            }
+            char *dst = blocks_.back().get() + used_;
+            std::memcpy(dst, token.data(), token.size());
+            used_ += token.size();
+            return std::string_view(dst, token.size());
+        }
+
+        flat_hash_set ids_;
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        std::size_t used_ = 0;
+    };
+
     template <typename Container>
     Container split(std::string_view str, std::string_view delimiter)
     {
@@ -33,7 +285,10 @@ namespace hazuki
                           std::is_same_v<Container, std::vector<std::string>> ||
                           std::is_same_v<Container, std::stack<std::string>> ||
                           std::is_same_v<Container, std::queue<std::string>> ||
-                          std::is_same_v<Container, std::pair<std::string, std::string>>,
+                          std::is_same_v<Container, std::pair<std::string, std::string>> ||
+                          std::is_same_v<Container, std::vector<std::string_view>> ||
+                          std::is_same_v<Container, flat_hash_set> ||
+                          std::is_same_v<Container, flat_set>,
                       "Unsupported container type");
 
         if (delimiter.empty())
@@ -41,6 +296,9 @@ namespace hazuki
             throw "Delimiter cannot be empty";
         }
 
+        // flat_set is filled in one sorted batch at the end
+        std::vector<std::string_view> pending;
+
         while ((end = str.find(delimiter, start)) != std::string_view::npos)
         {
             if constexpr (std::is_same_v<Container, std::set<std::string>> ||
@@ -56,6 +314,18 @@ namespace hazuki
             {
                 tokens.push(std::string(str.substr(start, end - start)));
             }
+            else if constexpr (std::is_same_v<Container, std::vector<std::string_view>>)
+            {
+                tokens.push_back(str.substr(start, end - start));
+            }
+            else if constexpr (std::is_same_v<Container, flat_hash_set>)
+            {
+                tokens.insert(str.substr(start, end - start));
+            }
+            else if constexpr (std::is_same_v<Container, flat_set>)
+            {
+                pending.push_back(str.substr(start, end - start));
+            }
             else if constexpr (std::is_same_v<Container, std::pair<std::string, std::string>>)
             {
                 size_t delimiter_pos = str.find(delimiter, start);
@@ -89,6 +359,18 @@ namespace hazuki
             {
                 tokens.push(std::string(str.substr(start)));
             }
+            else if constexpr (std::is_same_v<Container, std::vector<std::string_view>>)
+            {
+                tokens.push_back(str.substr(start));
+            }
+            else if constexpr (std::is_same_v<Container, flat_hash_set>)
+            {
+                tokens.insert(str.substr(start));
+            }
+            else if constexpr (std::is_same_v<Container, flat_set>)
+            {
+                pending.push_back(str.substr(start));
+            }
             else if constexpr (std::is_same_v<Container, std::pair<std::string, std::string>>)
             {
                 tokens.first = std::string(str.substr(start));
@@ -96,8 +378,37 @@ namespace hazuki
             }
         }
 
+        if constexpr (std::is_same_v<Container, flat_set>)
+        {
+            tokens.insert(pending.begin(), pending.end());
+        }
+
         return tokens;
     }
+
+    inline std::vector<std::uint32_t> split(std::string_view str, std::string_view delimiter, interner &pool)
+    {
+        std::vector<std::uint32_t> ids;
+        size_t start = 0, end = 0;
+
+        if (delimiter.empty())
+        {
+            throw "Delimiter cannot be empty";
+        }
+
+        while ((end = str.find(delimiter, start)) != std::string_view::npos)
+        {
+            ids.push_back(pool.intern(str.substr(start, end - start)));
+            start = end + delimiter.length();
+        }
+
+        if (!str.substr(start).empty())
+        {
+            ids.push_back(pool.intern(str.substr(start)));
+        }
+
+        return ids;
+    }
 }
 
 #endif
\ No newline at end of file
@@ -11,4 +11,19 @@ int main()
         cout << i << " ";
     }
     cout << endl;
+
+    string tags = "c,a,b,a,c";
+    hazuki::flat_set unique = hazuki::split<hazuki::flat_set>(tags, ",");
+    for (auto &i : unique)
+    {
+        cout << i << " ";
+    }
+    cout << endl;
+
+    hazuki::interner pool;
+    for (auto &id : hazuki::split(tags, ",", pool))
+    {
+        cout << id << " ";
+    }
+    cout << endl;
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#ifndef COROUTINE_HPP
+#define COROUTINE_HPP
+
+// 只在编译器支持 C++20 协程时提供
+#if defined(__cpp_impl_coroutine)
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+#include "./output_.hpp"
+#include "./metrics_.hpp"
+
+template <typename Awaitable>
+class CoroutineAwaiter_;
+
+// 取得 co_await 实际使用的等待体：优先成员 operator co_await，其次非成员 operator co_await，否则为自身
+template <typename Awaitable>
+decltype(auto) getAwaiter_(Awaitable &&awaitable)
+{
+    if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); })
+    {
+        return std::forward<Awaitable>(awaitable).operator co_await();
+    }
+    else if constexpr (requires { operator co_await(std::forward<Awaitable>(awaitable)); })
+    {
+        return operator co_await(std::forward<Awaitable>(awaitable));
+    }
+    else
+    {
+        return std::forward<Awaitable>(awaitable);
+    }
+}
+
+// 协程计时器
+// 放在协程帧中，用 co_await timer(awaitable) 等待，分别记录运行时间、挂起时间与恢复次数
+// 时间取自 steady_clock 的分段差值，与执行的线程无关，在其他线程上恢复时仍然正确
+// 挂起前的写入由恢复协程的一方（执行器、线程池等）同步到恢复后的线程，计时器本身不需要加锁
+class CoroutineTimer
+{
+public:
+    CoroutineTimer(const std::string &label = "timer",
+                   const std::string &mode = "std",
+                   const std::string &format = "[{time}] ({label}) {duration} seconds, {suspended} seconds suspended, {resumes} resumes.",
+                   const std::string &dst = "none",
+                   const int &PRECISION = 6)
+        : label_(label), mode_(mode), dst_(dst), PRECISION_(PRECISION), format_(format)
+    {
+        if (mode_ == "metrics")
+        {
+            series_ = &Metrics_::instance().series(label_);
+        }
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    template <typename Awaitable>
+    CoroutineAwaiter_<Awaitable> operator()(Awaitable &&awaitable)
+    {
+        return CoroutineAwaiter_<Awaitable>(*this, std::forward<Awaitable>(awaitable));
+    }
+
+    CoroutineTimer(const CoroutineTimer &) = delete;
+    CoroutineTimer &operator=(const CoroutineTimer &) = delete;
+
+    ~CoroutineTimer()
+    {
+        active_ += std::chrono::steady_clock::now() - start_;
+
+        // {duration} 为运行时间，{suspended} 与 {resumes} 在交给 Output_ 前替换
+        auto duration_ = std::chrono::duration_cast<std::chrono::microseconds>(active_);
+        std::string format = format_;
+        size_t pos;
+        while ((pos = format.find("{suspended}")) != std::string::npos)
+        {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(PRECISION_)
+               << (double)std::chrono::duration_cast<std::chrono::microseconds>(suspended_).count() / 1000000;
+            format.replace(pos, 11, ss.str());
+        }
+        while ((pos = format.find("{resumes}")) != std::string::npos)
+        {
+            format.replace(pos, 9, std::to_string(resumes_));
+        }
+
+        if (mode_ == "std")
+        {
+            Output_::stdOutput(label_, duration_, PRECISION_, format);
+        }
+        else if (mode_ == "log")
+        {
+            if (dst_ == "none")
+            {
+#ifdef _WIN32
+                Output_::logOutput(label_, duration_, PRECISION_, ".\\timer.log", format);
+#else
+                Output_::logOutput(label_, duration_, PRECISION_, "./timer.log", format);
+#endif
+            }
+            else
+            {
+                Output_::logOutput(label_, duration_, PRECISION_, dst_, format);
+            }
+        }
+        else if (mode_ == "metrics")
+        {
+            series_->record(duration_);
+        }
+    }
+
+private:
+    template <typename>
+    friend class CoroutineAwaiter_;
+
+    // 即将挂起：结束当前运行段
+    void suspend()
+    {
+        auto now = std::chrono::steady_clock::now();
+        active_ += now - start_;
+        start_ = now;
+        waiting_ = true;
+    }
+
+    // 未真正挂起（await_suspend 返回 false）：这段时间仍计为运行
+    void cancel()
+    {
+        waiting_ = false;
+    }
+
+    // 恢复后：挂起段计入挂起时间，开始新的运行段
+    void resume()
+    {
+        if (!waiting_)
+        {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        suspended_ += now - start_;
+        start_ = now;
+        waiting_ = false;
+        resumes_++;
+    }
+
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::duration active_{0};
+    std::chrono::steady_clock::duration suspended_{0};
+    unsigned long long resumes_ = 0;
+    bool waiting_ = false;
+    std::string label_;
+    std::string mode_;
+    std::string dst_;
+    int PRECISION_;
+    std::string format_;
+    MetricSeries_ *series_ = nullptr;
+};
+
+// 包装等待体，在挂起与恢复时通知计时器，其余行为与原等待体相同
+template <typename Awaitable>
+class CoroutineAwaiter_
+{
+public:
+    CoroutineAwaiter_(CoroutineTimer &timer, Awaitable &&awaitable)
+        : timer_(timer), awaitable_(std::forward<Awaitable>(awaitable)),
+          awaiter_(getAwaiter_(static_cast<Awaitable &&>(awaitable_)))
+    {
+    }
+
+    bool await_ready()
+    {
+        return awaiter_.await_ready();
+    }
+
+    // 内层 await_suspend 调用后协程可能已在其他线程上恢复甚至销毁，之后不能再访问计时器与本对象
+    template <typename Promise>
+    auto await_suspend(std::coroutine_handle<Promise> handle)
+    {
+        CoroutineTimer &timer = timer_;
+        timer.suspend();
+        using Result = decltype(awaiter_.await_suspend(handle));
+        if constexpr (std::is_same_v<Result, bool>)
+        {
+            bool suspended = awaiter_.await_suspend(handle);
+            if (!suspended)
+            {
+                // 返回 false 时协程没有挂起，仍在当前线程上运行
+                timer.cancel();
+            }
+            return suspended;
+        }
+        else
+        {
+            return awaiter_.await_suspend(handle);
+        }
+    }
+
+    decltype(auto) await_resume()
+    {
+        timer_.resume();
+        return awaiter_.await_resume();
+    }
+
+private:
+    CoroutineTimer &timer_;
+    Awaitable awaitable_; // 左值为引用，右值保存在包装内，与 co_await 表达式同生命周期
+    decltype(getAwaiter_(std::declval<Awaitable>())) awaiter_;
+};
+
+#endif
+
+#endif
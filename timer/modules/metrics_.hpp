@@ -0,0 +1,365 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <iostream>
+#include <chrono>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+// 同一个标签的统计：次数、总时长与各直方图桶的次数
+// 全部为原子变量，记录与快照都不加锁
+struct MetricSeries_
+{
+    // 直方图桶的上界（秒），从 1 微秒到 10 秒每 10 倍一个桶，最后一个桶为 +Inf
+    static constexpr std::array<double, 8> bounds_ = {1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1, 10};
+
+    explicit MetricSeries_(const std::string &label) : label_(label)
+    {
+        for (auto &bucket : buckets_)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(std::chrono::microseconds duration)
+    {
+        double seconds = (double)duration.count() / 1000000;
+        size_t bucket = 0;
+        while (bucket < bounds_.size() && seconds > bounds_[bucket])
+        {
+            bucket++;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add((uint64_t)duration.count(), std::memory_order_relaxed);
+    }
+
+    const std::string label_;
+    std::array<std::atomic<uint64_t>, bounds_.size() + 1> buckets_; // 每个桶单独计数，快照时再累加
+    std::atomic<uint64_t> sum_{0};                                   // 微秒
+    MetricSeries_ *next_ = nullptr;
+};
+
+// 所有标签的统计，进程内唯一
+// 标签组成只增不删的链表，新标签用 CAS 插入表头，遍历时不需要加锁
+class Metrics_
+{
+public:
+    static Metrics_ &instance()
+    {
+        static Metrics_ metrics;
+        return metrics;
+    }
+
+    // 查找标签对应的统计，不存在时创建；计时器在构造时查找一次并保存指针
+    MetricSeries_ &series(const std::string &label)
+    {
+        MetricSeries_ *head = head_.load(std::memory_order_acquire);
+        for (MetricSeries_ *node = head; node; node = node->next_)
+        {
+            if (node->label_ == label)
+            {
+                return *node;
+            }
+        }
+
+        MetricSeries_ *created = new MetricSeries_(label);
+        for (;;)
+        {
+            created->next_ = head;
+            if (head_.compare_exchange_weak(head, created, std::memory_order_release, std::memory_order_acquire))
+            {
+                return *created;
+            }
+            // 表头已变化，检查新插入的节点中是否已有同名标签
+            for (MetricSeries_ *node = head; node != created->next_; node = node->next_)
+            {
+                if (node->label_ == label)
+                {
+                    delete created;
+                    return *node;
+                }
+            }
+        }
+    }
+
+    // OpenMetrics 文本格式的快照
+    // 各字段分别读取，+Inf 桶与 _count 由同一组桶的读数累加，两者始终一致
+    std::string snapshot()
+    {
+        std::ostringstream ss;
+        ss << "# TYPE timer_duration_seconds histogram\n"
+           << "# UNIT timer_duration_seconds seconds\n"
+           << "# HELP timer_duration_seconds Time measured by timers.\n";
+        for (MetricSeries_ *node = head_.load(std::memory_order_acquire); node; node = node->next_)
+        {
+            std::string label = escape(node->label_);
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < node->buckets_.size(); i++)
+            {
+                cumulative += node->buckets_[i].load(std::memory_order_relaxed);
+                ss << "timer_duration_seconds_bucket{label=\"" << label << "\",le=\"";
+                if (i < MetricSeries_::bounds_.size())
+                {
+                    ss << MetricSeries_::bounds_[i];
+                }
+                else
+                {
+                    ss << "+Inf";
+                }
+                ss << "\"} " << cumulative << "\n";
+            }
+            // 总时长以整数微秒累计，拆为整秒与 6 位小数输出，不经过 double，长时间运行后仍保留每一微秒
+            uint64_t sum = node->sum_.load(std::memory_order_relaxed);
+            ss << "timer_duration_seconds_count{label=\"" << label << "\"} " << cumulative << "\n"
+               << "timer_duration_seconds_sum{label=\"" << label << "\"} "
+               << sum / 1000000 << "." << std::setw(6) << std::setfill('0') << sum % 1000000 << std::setfill(' ') << "\n";
+        }
+        ss << "# EOF\n";
+        return ss.str();
+    }
+
+    ~Metrics_()
+    {
+        MetricSeries_ *node = head_.load();
+        while (node)
+        {
+            MetricSeries_ *next = node->next_;
+            delete node;
+            node = next;
+        }
+    }
+
+private:
+    Metrics_() = default;
+
+    // 标签值中的反斜杠、双引号与换行需要转义
+    static std::string escape(const std::string &value)
+    {
+        std::string result;
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+            {
+                result += '\\';
+                result += c;
+            }
+            else if (c == '\n')
+            {
+                result += "\\n";
+            }
+            else
+            {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    std::atomic<MetricSeries_ *> head_{nullptr};
+};
+
+/**
+ * 后台导出线程：每隔 interval 毫秒将快照写入临时文件后重命名为 path，
+ * 读取方看到的始终是完整的文件；port 不为 0 时同时在 127.0.0.1:port 上以 HTTP 提供快照
+ * path 为空时只提供 HTTP。析构时停止线程并写出最后一次快照
+ */
+class MetricsExporter
+{
+public:
+    MetricsExporter(const std::string &path = "./timer.prom",
+                    const int &interval = 1000,
+                    const int &port = 0)
+        : path_(path), interval_(interval)
+    {
+        // 先于导出线程构造统计表，使其晚于导出线程析构，最后一次写出时仍然有效
+        Metrics_::instance();
+        if (port != 0)
+        {
+            listen(port);
+        }
+        thread_ = std::thread(&MetricsExporter::run, this);
+    }
+
+    ~MetricsExporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        stopped_.notify_one();
+        thread_.join();
+        write();
+#ifndef _WIN32
+        if (server_ >= 0)
+        {
+            close(server_);
+        }
+#endif
+    }
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+private:
+    void run()
+    {
+        auto next = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next)
+            {
+                lock.unlock();
+                write();
+                lock.lock();
+                next = now + std::chrono::milliseconds(interval_);
+                continue;
+            }
+
+            // 有 HTTP 端口时在等待期间处理请求，每次最多等待 100 毫秒以便及时停止；否则直接等到下一次写出或停止
+            if (server_ >= 0)
+            {
+                lock.unlock();
+                auto wait = std::min<std::chrono::steady_clock::duration>(next - now, std::chrono::milliseconds(100));
+                serve(std::chrono::duration_cast<std::chrono::milliseconds>(wait));
+                lock.lock();
+            }
+            else
+            {
+                stopped_.wait_until(lock, next, [this]
+                                    { return stop_; });
+            }
+        }
+    }
+
+    // 先写临时文件，再重命名覆盖目标文件
+    void write()
+    {
+        if (path_.empty())
+        {
+            return;
+        }
+        std::string temp = path_ + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            if (!file.is_open())
+            {
+                std::cerr << "\nFailed to open metrics file." << std::endl;
+                return;
+            }
+            file << Metrics_::instance().snapshot();
+        }
+#ifdef _WIN32
+        MoveFileExA(temp.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+        std::rename(temp.c_str(), path_.c_str());
+#endif
+    }
+
+#ifdef _WIN32
+    // Windows 上只支持文件导出
+    void listen(int)
+    {
+        std::cerr << "\nMetrics HTTP export is not supported on Windows." << std::endl;
+    }
+
+    void serve(std::chrono::milliseconds)
+    {
+    }
+#else
+    void listen(int port)
+    {
+        server_ = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(server_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (server_ < 0 || bind(server_, (sockaddr *)&address, sizeof(address)) != 0 || ::listen(server_, 8) != 0)
+        {
+            std::cerr << "\nFailed to listen on metrics port." << std::endl;
+            if (server_ >= 0)
+            {
+                close(server_);
+            }
+            server_ = -1;
+        }
+    }
+
+    // 最多等待 timeout，对每个连接读取请求后返回当前快照
+    void serve(std::chrono::milliseconds timeout)
+    {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(server_, &readable);
+        timeval wait{(time_t)(timeout.count() / 1000), (suseconds_t)(timeout.count() % 1000 * 1000)};
+        if (select(server_ + 1, &readable, nullptr, nullptr, &wait) <= 0)
+        {
+            return;
+        }
+
+        int client = accept(server_, nullptr, nullptr);
+        if (client < 0)
+        {
+            return;
+        }
+        // 请求内容不影响响应，只读取一次，客户端不发送时最多等待 1 秒
+        timeval receiveTimeout{1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+        char request[1024];
+        recv(client, request, sizeof(request), 0);
+
+        std::string body = Metrics_::instance().snapshot();
+        std::string response = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + body;
+        for (size_t sent = 0; sent < response.size();)
+        {
+#ifdef MSG_NOSIGNAL
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, 0);
+#endif
+            if (n <= 0)
+            {
+                break;
+            }
+            sent += (size_t)n;
+        }
+        close(client);
+    }
+#endif
+
+    std::string path_;
+    int interval_;
+    int server_ = -1;
+    bool stop_ = false;
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    std::thread thread_;
+};
+
+#endif
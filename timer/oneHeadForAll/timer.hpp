@@ -16,13 +16,26 @@
  *
  *      参数：
  *      label: 标签，默认为"timer"
- *      mode: 输出模式，默认为"std"，可选"log"
+ *      mode: 输出模式，默认为"std"，可选"log"、"metrics"
  *      format: 输出格式，默认为"[{time}] ({label}) {duration} seconds."，还有{commitID}可选
  *      dst: 输出目标，默认为"none"，即在工作目录下输出，设置输出路径
  *      PRECISION: 保留小数位数，默认为6
  *
  *      参数可以缺省，但必须顺序填写，否则会出错
  *
+ *      协程计时器（C++20）：
+ *      CoroutineTimer timer(label, mode, format, dst, PRECISION);
+ *      co_await timer(awaitable);
+ *          在协程帧中创建，经 timer(...) 包装的 co_await 会分别记录运行时间、挂起时间与恢复次数，
+ *          在其他线程上恢复时仍然正确，析构时输出；format 中 {duration} 为运行时间，另有{suspended}、{resumes}可选
+ *
+ *      导出：
+ *      MetricsExporter exporter(path, interval, port);
+ *          mode 为"metrics"的计时器不输出，而是按标签累计次数、总时长与直方图桶，
+ *          导出线程每隔 interval 毫秒以 OpenMetrics 文本格式原子地重写 path（先写临时文件再重命名），
+ *          port 不为 0 时同时在 127.0.0.1:port 上以 HTTP 提供，供 Prometheus 抓取
+ *          path 默认为"./timer.prom"，interval 默认为1000，port 默认为0
+ *
  * 该对象示例会在构建时自动初始化，析构时自动输出，不会影响原代码的运行时间
  *
  * 作者：Hazuki
@@ -41,8 +54,23 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
 #endif
 
 // 跨平台终端颜色控制
@@ -243,6 +271,343 @@ public:
     };
 };
 
+// 同一个标签的统计：次数、总时长与各直方图桶的次数
+// 全部为原子变量，记录与快照都不加锁
+struct MetricSeries_
+{
+    // 直方图桶的上界（秒），从 1 微秒到 10 秒每 10 倍一个桶，最后一个桶为 +Inf
+    static constexpr std::array<double, 8> bounds_ = {1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1, 10};
+
+    explicit MetricSeries_(const std::string &label) : label_(label)
+    {
+        for (auto &bucket : buckets_)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(std::chrono::microseconds duration)
+    {
+        double seconds = (double)duration.count() / 1000000;
+        size_t bucket = 0;
+        while (bucket < bounds_.size() && seconds > bounds_[bucket])
+        {
+            bucket++;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add((uint64_t)duration.count(), std::memory_order_relaxed);
+    }
+
+    const std::string label_;
+    std::array<std::atomic<uint64_t>, bounds_.size() + 1> buckets_; // 每个桶单独计数，快照时再累加
+    std::atomic<uint64_t> sum_{0};                                   // 微秒
+    MetricSeries_ *next_ = nullptr;
+};
+
+// 所有标签的统计，进程内唯一
+// 标签组成只增不删的链表，新标签用 CAS 插入表头，遍历时不需要加锁
+class Metrics_
+{
+public:
+    static Metrics_ &instance()
+    {
+        static Metrics_ metrics;
+        return metrics;
+    }
+
+    // 查找标签对应的统计，不存在时创建；计时器在构造时查找一次并保存指针
+    MetricSeries_ &series(const std::string &label)
+    {
+        MetricSeries_ *head = head_.load(std::memory_order_acquire);
+        for (MetricSeries_ *node = head; node; node = node->next_)
+        {
+            if (node->label_ == label)
+            {
+                return *node;
+            }
+        }
+
+        MetricSeries_ *created = new MetricSeries_(label);
+        for (;;)
+        {
+            created->next_ = head;
+            if (head_.compare_exchange_weak(head, created, std::memory_order_release, std::memory_order_acquire))
+            {
+                return *created;
+            }
+            // 表头已变化，检查新插入的节点中是否已有同名标签
+            for (MetricSeries_ *node = head; node != created->next_; node = node->next_)
+            {
+                if (node->label_ == label)
+                {
+                    delete created;
+                    return *node;
+                }
+            }
+        }
+    }
+
+    // OpenMetrics 文本格式的快照
+    // 各字段分别读取，+Inf 桶与 _count 由同一组桶的读数累加，两者始终一致
+    std::string snapshot()
+    {
+        std::ostringstream ss;
+        ss << "# TYPE timer_duration_seconds histogram\n"
+           << "# UNIT timer_duration_seconds seconds\n"
+           << "# HELP timer_duration_seconds Time measured by timers.\n";
+        for (MetricSeries_ *node = head_.load(std::memory_order_acquire); node; node = node->next_)
+        {
+            std::string label = escape(node->label_);
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < node->buckets_.size(); i++)
+            {
+                cumulative += node->buckets_[i].load(std::memory_order_relaxed);
+                ss << "timer_duration_seconds_bucket{label=\"" << label << "\",le=\"";
+                if (i < MetricSeries_::bounds_.size())
+                {
+                    ss << MetricSeries_::bounds_[i];
+                }
+                else
+                {
+                    ss << "+Inf";
+                }
+                ss << "\"} " << cumulative << "\n";
+            }
+            // 总时长以整数微秒累计，拆为整秒与 6 位小数输出，不经过 double，长时间运行后仍保留每一微秒
+            uint64_t sum = node->sum_.load(std::memory_order_relaxed);
+            ss << "timer_duration_seconds_count{label=\"" << label << "\"} " << cumulative << "\n"
+               << "timer_duration_seconds_sum{label=\"" << label << "\"} "
+               << sum / 1000000 << "." << std::setw(6) << std::setfill('0') << sum % 1000000 << std::setfill(' ') << "\n";
+        }
+        ss << "# EOF\n";
+        return ss.str();
+    }
+
+    ~Metrics_()
+    {
+        MetricSeries_ *node = head_.load();
+        while (node)
+        {
+            MetricSeries_ *next = node->next_;
+            delete node;
+            node = next;
+        }
+    }
+
+private:
+    Metrics_() = default;
+
+    // 标签值中的反斜杠、双引号与换行需要转义
+    static std::string escape(const std::string &value)
+    {
+        std::string result;
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+            {
+                result += '\\';
+                result += c;
+            }
+            else if (c == '\n')
+            {
+                result += "\\n";
+            }
+            else
+            {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    std::atomic<MetricSeries_ *> head_{nullptr};
+};
+
+/**
+ * 后台导出线程：每隔 interval 毫秒将快照写入临时文件后重命名为 path，
+ * 读取方看到的始终是完整的文件；port 不为 0 时同时在 127.0.0.1:port 上以 HTTP 提供快照
+ * path 为空时只提供 HTTP。析构时停止线程并写出最后一次快照
+ */
+class MetricsExporter
+{
+public:
+    MetricsExporter(const std::string &path = "./timer.prom",
+                    const int &interval = 1000,
+                    const int &port = 0)
+        : path_(path), interval_(interval)
+    {
+        // 先于导出线程构造统计表，使其晚于导出线程析构，最后一次写出时仍然有效
+        Metrics_::instance();
+        if (port != 0)
+        {
+            listen(port);
+        }
+        thread_ = std::thread(&MetricsExporter::run, this);
+    }
+
+    ~MetricsExporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        stopped_.notify_one();
+        thread_.join();
+        write();
+#ifndef _WIN32
+        if (server_ >= 0)
+        {
+            close(server_);
+        }
+#endif
+    }
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+private:
+    void run()
+    {
+        auto next = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next)
+            {
+                lock.unlock();
+                write();
+                lock.lock();
+                next = now + std::chrono::milliseconds(interval_);
+                continue;
+            }
+
+            // 有 HTTP 端口时在等待期间处理请求，每次最多等待 100 毫秒以便及时停止；否则直接等到下一次写出或停止
+            if (server_ >= 0)
+            {
+                lock.unlock();
+                auto wait = std::min<std::chrono::steady_clock::duration>(next - now, std::chrono::milliseconds(100));
+                serve(std::chrono::duration_cast<std::chrono::milliseconds>(wait));
+                lock.lock();
+            }
+            else
+            {
+                stopped_.wait_until(lock, next, [this]
+                                    { return stop_; });
+            }
+        }
+    }
+
+    // 先写临时文件，再重命名覆盖目标文件
+    void write()
+    {
+        if (path_.empty())
+        {
+            return;
+        }
+        std::string temp = path_ + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            if (!file.is_open())
+            {
+                std::cerr << "\nFailed to open metrics file." << std::endl;
+                return;
+            }
+            file << Metrics_::instance().snapshot();
+        }
+#ifdef _WIN32
+        MoveFileExA(temp.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+        std::rename(temp.c_str(), path_.c_str());
+#endif
+    }
+
+#ifdef _WIN32
+    // Windows 上只支持文件导出
+    void listen(int)
+    {
+        std::cerr << "\nMetrics HTTP export is not supported on Windows." << std::endl;
+    }
+
+    void serve(std::chrono::milliseconds)
+    {
+    }
+#else
+    void listen(int port)
+    {
+        server_ = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(server_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (server_ < 0 || bind(server_, (sockaddr *)&address, sizeof(address)) != 0 || ::listen(server_, 8) != 0)
+        {
+            std::cerr << "\nFailed to listen on metrics port." << std::endl;
+            if (server_ >= 0)
+            {
+                close(server_);
+            }
+            server_ = -1;
+        }
+    }
+
+    // 最多等待 timeout，对每个连接读取请求后返回当前快照
+    void serve(std::chrono::milliseconds timeout)
+    {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(server_, &readable);
+        timeval wait{(time_t)(timeout.count() / 1000), (suseconds_t)(timeout.count() % 1000 * 1000)};
+        if (select(server_ + 1, &readable, nullptr, nullptr, &wait) <= 0)
+        {
+            return;
+        }
+
+        int client = accept(server_, nullptr, nullptr);
+        if (client < 0)
+        {
+            return;
+        }
+        // 请求内容不影响响应，只读取一次，客户端不发送时最多等待 1 秒
+        timeval receiveTimeout{1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+        char request[1024];
+        recv(client, request, sizeof(request), 0);
+
+        std::string body = Metrics_::instance().snapshot();
+        std::string response = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + body;
+        for (size_t sent = 0; sent < response.size();)
+        {
+#ifdef MSG_NOSIGNAL
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, 0);
+#endif
+            if (n <= 0)
+            {
+                break;
+            }
+            sent += (size_t)n;
+        }
+        close(client);
+    }
+#endif
+
+    std::string path_;
+    int interval_;
+    int server_ = -1;
+    bool stop_ = false;
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    std::thread thread_;
+};
+
 // 手动计时器
 class ManualTimer
 {
@@ -254,7 +619,11 @@ public:
                 const int &PRECISION = 6)
         : label_(label), mode_(mode), dst_(dst), PRECISION_(PRECISION), format_(format)
     {
-        ;
+        // 导出模式在构造时找到标签对应的统计，析构时只做原子累加
+        if (mode_ == "metrics")
+        {
+            series_ = &Metrics_::instance().series(label_);
+        }
     }
 
     void start()
@@ -294,6 +663,10 @@ public:
                 Output_::logOutput(label_, duration_, PRECISION_, dst_, format_);
             }
         }
+        else if (mode_ == "metrics")
+        {
+            series_->record(duration_);
+        }
     }
 
 protected:
@@ -304,6 +677,7 @@ protected:
     std::string dst_;
     int PRECISION_;
     std::string format_;
+    MetricSeries_ *series_ = nullptr;
 };
 
 // 自动计数器
@@ -326,4 +700,206 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+// 协程计时器只在编译器支持 C++20 协程时提供
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+template <typename Awaitable>
+class CoroutineAwaiter_;
+
+// 取得 co_await 实际使用的等待体：优先成员 operator co_await，其次非成员 operator co_await，否则为自身
+template <typename Awaitable>
+decltype(auto) getAwaiter_(Awaitable &&awaitable)
+{
+    if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); })
+    {
+        return std::forward<Awaitable>(awaitable).operator co_await();
+    }
+    else if constexpr (requires { operator co_await(std::forward<Awaitable>(awaitable)); })
+    {
+        return operator co_await(std::forward<Awaitable>(awaitable));
+    }
+    else
+    {
+        return std::forward<Awaitable>(awaitable);
+    }
+}
+
+// 协程计时器
+// 放在协程帧中，用 co_await timer(awaitable) 等待，分别记录运行时间、挂起时间与恢复次数
+// 时间取自 steady_clock 的分段差值，与执行的线程无关，在其他线程上恢复时仍然正确
+// 挂起前的写入由恢复协程的一方（执行器、线程池等）同步到恢复后的线程，计时器本身不需要加锁
+class CoroutineTimer
+{
+public:
+    CoroutineTimer(const std::string &label = "timer",
+                   const std::string &mode = "std",
+                   const std::string &format = "[{time}] ({label}) {duration} seconds, {suspended} seconds suspended, {resumes} resumes.",
+                   const std::string &dst = "none",
+                   const int &PRECISION = 6)
+        : label_(label), mode_(mode), dst_(dst), PRECISION_(PRECISION), format_(format)
+    {
+        if (mode_ == "metrics")
+        {
+            series_ = &Metrics_::instance().series(label_);
+        }
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    template <typename Awaitable>
+    CoroutineAwaiter_<Awaitable> operator()(Awaitable &&awaitable)
+    {
+        return CoroutineAwaiter_<Awaitable>(*this, std::forward<Awaitable>(awaitable));
+    }
+
+    CoroutineTimer(const CoroutineTimer &) = delete;
+    CoroutineTimer &operator=(const CoroutineTimer &) = delete;
+
+    ~CoroutineTimer()
+    {
+        active_ += std::chrono::steady_clock::now() - start_;
+
+        // {duration} 为运行时间，{suspended} 与 {resumes} 在交给 Output_ 前替换
+        auto duration_ = std::chrono::duration_cast<std::chrono::microseconds>(active_);
+        std::string format = format_;
+        size_t pos;
+        while ((pos = format.find("{suspended}")) != std::string::npos)
+        {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(PRECISION_)
+               << (double)std::chrono::duration_cast<std::chrono::microseconds>(suspended_).count() / 1000000;
+            format.replace(pos, 11, ss.str());
+        }
+        while ((pos = format.find("{resumes}")) != std::string::npos)
+        {
+            format.replace(pos, 9, std::to_string(resumes_));
+        }
+
+        if (mode_ == "std")
+        {
+            Output_::stdOutput(label_, duration_, PRECISION_, format);
+        }
+        else if (mode_ == "log")
+        {
+            if (dst_ == "none")
+            {
+#ifdef _WIN32
+                Output_::logOutput(label_, duration_, PRECISION_, ".\\timer.log", format);
+#else
+                Output_::logOutput(label_, duration_, PRECISION_, "./timer.log", format);
+#endif
+            }
+            else
+            {
+                Output_::logOutput(label_, duration_, PRECISION_, dst_, format);
+            }
+        }
+        else if (mode_ == "metrics")
+        {
+            series_->record(duration_);
+        }
+    }
+
+private:
+    template <typename>
+    friend class CoroutineAwaiter_;
+
+    // 即将挂起：结束当前运行段
+    void suspend()
+    {
+        auto now = std::chrono::steady_clock::now();
+        active_ += now - start_;
+        start_ = now;
+        waiting_ = true;
+    }
+
+    // 未真正挂起（await_suspend 返回 false）：这段时间仍计为运行
+    void cancel()
+    {
+        waiting_ = false;
+    }
+
+    // 恢复后：挂起段计入挂起时间，开始新的运行段
+    void resume()
+    {
+        if (!waiting_)
+        {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        suspended_ += now - start_;
+        start_ = now;
+        waiting_ = false;
+        resumes_++;
+    }
+
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::duration active_{0};
+    std::chrono::steady_clock::duration suspended_{0};
+    unsigned long long resumes_ = 0;
+    bool waiting_ = false;
+    std::string label_;
+    std::string mode_;
+    std::string dst_;
+    int PRECISION_;
+    std::string format_;
+    MetricSeries_ *series_ = nullptr;
+};
+
+// 包装等待体，在挂起与恢复时通知计时器，其余行为与原等待体相同
+template <typename Awaitable>
+class CoroutineAwaiter_
+{
+public:
+    CoroutineAwaiter_(CoroutineTimer &timer, Awaitable &&awaitable)
+        : timer_(timer), awaitable_(std::forward<Awaitable>(awaitable)),
+          awaiter_(getAwaiter_(static_cast<Awaitable &&>(awaitable_)))
+    {
+    }
+
+    bool await_ready()
+    {
+        return awaiter_.await_ready();
+    }
+
+    // 内层 await_suspend 调用后协程可能已在其他线程上恢复甚至销毁，之后不能再访问计时器与本对象
+    template <typename Promise>
+    auto await_suspend(std::coroutine_handle<Promise> handle)
+    {
+        CoroutineTimer &timer = timer_;
+        timer.suspend();
+        using Result = decltype(awaiter_.await_suspend(handle));
+        if constexpr (std::is_same_v<Result, bool>)
+        {
+            bool suspended = awaiter_.await_suspend(handle);
+            if (!suspended)
+            {
+                // 返回 false 时协程没有挂起，仍在当前线程上运行
+                timer.cancel();
+            }
+            return suspended;
+        }
+        else
+        {
+            return awaiter_.await_suspend(handle);
+        }
+    }
+
+    decltype(auto) await_resume()
+    {
+        timer_.resume();
+        return awaiter_.await_resume();
+    }
+
+private:
+    CoroutineTimer &timer_;
+    Awaitable awaitable_; // 左值为引用，右值保存在包装内，与 co_await 表达式同生命周期
+    decltype(getAwaiter_(std::declval<Awaitable>())) awaiter_;
+};
+
+#endif
+
+#endif
@@ -1,5 +1,8 @@
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <random>
 #include "./timer.hpp"
 
@@ -9,6 +12,7 @@ ManualTimer timer2("manual2", "std", "[{time}] ({label}) {duration} seconds.", "
 
 double estimate_pi(long long total_points)
 {
+    AutoTimer timer("estimate_pi", "metrics");
     std::random_device rd;  // 获取一个随机数种子
     std::mt19937 gen(rd()); // 使用Mersenne Twister算法生成伪随机数
     std::uniform_real_distribution<> dis(0.0, 1.0);
@@ -27,6 +31,48 @@ double estimate_pi(long long total_points)
     return 4.0 * inside_circle / total_points;
 }
 
+#if defined(__cpp_impl_coroutine)
+// 立即开始、结束后自行销毁的协程
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// 在新线程上等待后恢复协程，线程交给调用方 join
+struct Delay
+{
+    int milliseconds;
+    std::thread &worker;
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // 新线程启动后协程帧（连同本对象）可能随时被销毁，先取出引用
+        std::thread &target = worker;
+        target = std::thread([handle, ms = milliseconds]
+                             {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            handle.resume(); });
+    }
+    void await_resume() {}
+};
+
+// 挂起的 200 毫秒计入挂起时间，不计入运行时间
+// 恢复后的部分连同计时器的析构与输出都在 worker 线程上完成
+Task estimate_pi_async(long long total_points, std::thread &worker)
+{
+    CoroutineTimer timer("coroutine");
+    co_await timer(Delay{200, worker});
+    std::cout << "协程估算的PI值: " << estimate_pi(total_points) << std::endl;
+}
+#endif
+
 int main()
 {
     std::cout << "开始估计PI值..." << std::endl;
@@ -50,7 +96,29 @@ int main()
     double pi_estimate = estimate_pi(total_points);
     timer2.end();
 
+    // 多次调用的耗时分布写入临时目录中的 timer.prom，导出器析构时最后写出一次，打印后删除
+    std::string promPath = (std::filesystem::temp_directory_path() / "timer.prom").string();
+    {
+        MetricsExporter exporter(promPath, 1000);
+        for (int i = 0; i < 10; i++)
+        {
+            estimate_pi(total_points / 100);
+        }
+    }
+    {
+        std::ifstream prom(promPath);
+        std::cout << prom.rdbuf();
+    }
+    std::remove(promPath.c_str());
+
     std::cout << "估算的PI值: " << pi_estimate << std::endl;
 
+#if defined(__cpp_impl_coroutine)
+    // 协程在第一次挂起时返回，join 等到协程执行完毕、计时器输出结束
+    std::thread worker;
+    estimate_pi_async(total_points / 10, worker);
+    worker.join();
+#endif
+
     return 0;
 }
\ No newline at end of file
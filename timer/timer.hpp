@@ -16,13 +16,26 @@
  *
  *      参数：
  *      label: 标签，默认为"timer"
- *      mode: 输出模式，默认为"std"，可选"log"
+ *      mode: 输出模式，默认为"std"，可选"log"、"metrics"
  *      format: 输出格式，默认为"[{time}] ({label}) {duration} seconds."，还有{commitID}可选
  *      dst: 输出目标，默认为"none"，即在工作目录下输出，设置输出路径
  *      PRECISION: 保留小数位数，默认为6
  *
  *      参数可以缺省，但必须顺序填写，否则会出错
  *
+ *      协程计时器（C++20）：
+ *      CoroutineTimer timer(label, mode, format, dst, PRECISION);
+ *      co_await timer(awaitable);
+ *          在协程帧中创建，经 timer(...) 包装的 co_await 会分别记录运行时间、挂起时间与恢复次数，
+ *          在其他线程上恢复时仍然正确，析构时输出；format 中 {duration} 为运行时间，另有{suspended}、{resumes}可选
+ *
+ *      导出：
+ *      MetricsExporter exporter(path, interval, port);
+ *          mode 为"metrics"的计时器不输出，而是按标签累计次数、总时长与直方图桶，
+ *          导出线程每隔 interval 毫秒以 OpenMetrics 文本格式原子地重写 path（先写临时文件再重命名），
+ *          port 不为 0 时同时在 127.0.0.1:port 上以 HTTP 提供，供 Prometheus 抓取
+ *          path 默认为"./timer.prom"，interval 默认为1000，port 默认为0
+ *
  * 该对象示例会在构建时自动初始化，析构时自动输出，不会影响原代码的运行时间
  *
  * 作者：Hazuki
@@ -34,6 +47,8 @@
 
 #include "./modules/terminalColor_.hpp"
 #include "./modules/output_.hpp"
+#include "./modules/metrics_.hpp"
+#include "./modules/coroutine_.hpp"
 
 // 手动计时器
 class ManualTimer
@@ -46,7 +61,11 @@ public:
                 const int &PRECISION = 6)
         : label_(label), mode_(mode), dst_(dst), PRECISION_(PRECISION), format_(format)
     {
-        ;
+        // 导出模式在构造时找到标签对应的统计，析构时只做原子累加
+        if (mode_ == "metrics")
+        {
+            series_ = &Metrics_::instance().series(label_);
+        }
     }
 
     void start()
@@ -86,6 +105,10 @@ public:
                 Output_::logOutput(label_, duration_, PRECISION_, dst_, format_);
             }
         }
+        else if (mode_ == "metrics")
+        {
+            series_->record(duration_);
+        }
     }
 
 protected:
@@ -96,6 +119,7 @@ protected:
     std::string dst_;
     int PRECISION_;
     std::string format_;
+    MetricSeries_ *series_ = nullptr;
 };
 
 // 自动计数器